@@ -97,10 +97,67 @@
 #define NEAREST 0
 #define LINEAR 1
 #define CUBIC 2
+#define BSPLINE 3
+#define LANCZOS 4
 
 #define DO_OVERWRITE 0
 #define NO_OVERWRITE 1
 
+#define STORAGE_FLOAT 0
+#define STORAGE_HALF 1
+
+// Largest absolute value of the scaled data stored as half floats, leaves room for the inverse whitening in the permutations
+#define HALF_STORAGE_MAX_VALUE 256.0f
+
+// Part of the free global memory that is used for one block of brain voxels in the first level GLM
+#define FIRST_LEVEL_BLOCK_MEMORY_FRACTION 0.5
+
+#define BATCHED_CHOLESKY 0
+#define BATCHED_LDLT 1
+#define BATCHED_QR 2
+
+// Largest system size for the batched solver kernels (kernelSolvers.cpp), larger systems are solved on the host
+#define MAX_BATCHED_SOLVER_SIZE 32
+
+// Number of systems that one thread solves at the same time in the host version of the batched solvers
+#define BATCHED_SOLVER_HOST_CHUNK 64
+
+#define WHITEN_DESIGN_INVERSE 0
+#define WHITEN_DESIGN_TTEST 1
+#define WHITEN_DESIGN_FTEST 2
+
+// Number of permutation vectors that are copied to the device at the same time in the first level permutation test
+#define PERMUTATION_VECTOR_BLOCK_SIZE 256
+
+// Largest number of contrasts times regressors in one batch of the batched second level permutation test (kernelStatistics2.cpp)
+#define MAX_BATCHED_CONTRAST_VALUES 64
+
+// Largest Bayesian GLM that the Gibbs sampler kernels can store in private memory, must match kernelBayesian.cpp
+#define MAX_BAYESIAN_REGRESSORS 16
+#define MAX_BAYESIAN_NUISANCE_REGRESSORS 32
+#define MAX_BAYESIAN_CONTRASTS 32
+
+#define BAYESIAN_VOXEL_LIST 0
+#define BAYESIAN_VOLUME 1
+
+#define BAYESIAN_MCMC 0
+#define BAYESIAN_VARIATIONAL 1
+
+// Highest order of the AR noise model for variational Bayes, must match kernelBayesian.cpp
+#define MAX_VB_AR_ORDER 4
+
+// Largest number of orthonormal nuisance basis vectors, all are removed in one pass, must match kernelStatistics1.cpp
+#define MAX_NUISANCE_REGRESSORS 128
+
+// Basis sets for regressors created from event tables
+#define HRF_BASIS_CANONICAL 0
+#define HRF_BASIS_INFORMED 1
+#define HRF_BASIS_FIR 2
+#define HRF_BASIS_GAMMA 3
+
+// Number of microtime samples per TR for regressors created from event tables
+#define MICROTIME_RESOLUTION 16
+
 #define PI 3.14159265359
 
 #define INITIAL_MM_T1_Z_CUT 15
@@ -108,9 +165,50 @@
 #define SUCCESS 0
 #define FAIL 1
 
+#define PROFILE_KERNEL 0
+#define PROFILE_READ 1
+#define PROFILE_WRITE 2
+#define PROFILE_COPY 3
+#define PROFILE_COPY_TO_IMAGE 4
+
+#define NONSEPARABLE_CONVOLUTION_32KB_512THREADS 0
+#define NONSEPARABLE_CONVOLUTION_24KB_1024THREADS 1
+#define NONSEPARABLE_CONVOLUTION_32KB_256THREADS 2
+#define NONSEPARABLE_CONVOLUTION_GLOBAL_MEMORY 3
+
 #define LOWPASS 0
 #define RANDOM 1
 
+#define SMOOTHING_METHOD_AUTOMATIC 0
+#define SMOOTHING_METHOD_FIR 1
+#define SMOOTHING_METHOD_RECURSIVE 2
+
+#define LAYOUT_TILE_SIZE 32
+#define LAYOUT_CHUNK_SIZE 16384
+
+#define REDUCTION_SUM 0
+#define REDUCTION_MEAN 1
+#define REDUCTION_MIN 2
+#define REDUCTION_MAX 3
+#define REDUCTION_CENTER_OF_MASS 4
+#define REDUCTION_QUALITY 5
+
+#define REDUCTION_COMPONENTS 4
+#define REDUCTION_THREADS 256
+#define REDUCTION_VOXELS_PER_THREAD 16
+#define REDUCTION_MAX_GROUPS 64
+#define REDUCTION_BATCH_SIZE 67108864
+
+// Radius (mm) of the sphere used to convert rotations to displacements, for the framewise displacement
+#define FRAMEWISE_DISPLACEMENT_RADIUS 50.0f
+
+#define EPI_MASK_METHOD_MEAN 0
+#define EPI_MASK_METHOD_OTSU 1
+#define EPI_MASK_METHOD_PERCENTILE 2
+#define EPI_MASK_HISTOGRAM_BINS 256
+
+#define COMBINED_TRANSFORM_BATCH_SIZE 268435456
+
 #define NVIDIA 0
 #define INTEL 1
 #define AMD 2
@@ -31,6 +31,8 @@
 #include <opencl.h>
 #include <string>
 #include <vector>
+#include <complex>
+#include <map>
 #include <Dense>
 
 typedef unsigned int uint;
@@ -39,6 +41,19 @@ typedef unsigned short int uint16;
 
 struct float2 {float x; float y;};
 
+// One enqueued OpenCL command in the profiling timeline, times are in ns from the OpenCL events
+struct OpenCLProfilingRecord
+{
+	char name[128];
+	int type;
+	cl_uint workDim;
+	size_t globalWorkSize[3];
+	size_t localWorkSize[3];
+	size_t bytes;
+	cl_event event;
+	cl_ulong queued, submit, start, end;
+};
+
 // Enumerated constants for axes
 enum { X, Y, Z };
 
@@ -129,10 +144,26 @@ class BROCCOLI_LIB
 		void SetSmoothedEPIMask(float* input);
 		void SetAutoMask(bool);
 
+		// EPI brain mask estimation, used when no mask is provided
+		void SetEPIMaskMethod(int method);
+		void SetEPIMaskPercentileFraction(float fraction);
+		void SetEPIMaskSmoothingAmount(float mm);
+		void SetEPIMaskFromMeanVolume(bool mean);
+		void SetEPIMaskLargestComponent(bool largest);
+		void SetEPIMaskFillHoles(bool fill);
+		void SetEPIMaskErosions(int erosions);
+		void SetEPIMaskDilations(int dilations);
+
 		// Statistics
 		void SetTemporalDerivatives(size_t TD);
+		void SetEventDesign(int numberOfEventTypes, int* numberOfEvents, float* onsets, float* durations, float* amplitudes);
+		void SetHRFBasis(int basis);
+		void SetNumberOfBasisFunctions(int N);
+		void SetBasisFunctionLength(float length);
+		int GetNumberOfBasisFunctions();
 		void SetBayesian(bool B);
 		void SetRegressOnly(bool R);
+		void SetStreamRuns(bool S);
 		void SetPreprocessingOnly(bool B);
 		void SetBetasOnly(bool B);
 		void SetContrastsOnly(bool C);
@@ -140,6 +171,12 @@ class BROCCOLI_LIB
 		void SetRegressMotion(size_t R);
 		void SetRegressGlobalMean(size_t R);
 		void SetRegressConfounds(size_t R);
+		void SetHighpassCutoff(float cutoff);
+		void SetCompCorTissueMaps(float* h_WM_Map, float* h_CSF_Map);
+		void SetNumberOfCompCorComponents(int N);
+		void SetCompCorThreshold(float threshold);
+		void SetFramewiseDisplacementThreshold(float threshold);
+		void SetDVARSThreshold(float threshold);
 		void SetPermuteFirstLevel(bool);
 		void SetConfoundRegressors(float* X_GLM);
 		void SetNumberOfGLMRegressors(size_t NR);
@@ -151,11 +188,23 @@ class BROCCOLI_LIB
 		void SetContrasts(float* contrasts);
 		void SetGLMScalars(float* ctxtxc);
 		void SetNumberOfPermutations(size_t);
+		void SetStoragePrecision(int);
+		void SetFirstLevelBlockSize(size_t);
 		void SetNumberOfGroupPermutations(size_t*);
+		void SetBatchContrastPermutations(bool B);
+		void SetCorrectAcrossContrasts(bool C);
 		void SetNumberOfMCMCIterations(int);
+		void SetBayesianExecutionMode(int mode);
+		void SetMCMCSeed(unsigned int seed);
+		void SetBayesianMethod(int method);
+		void SetVariationalBayesAROrder(int order);
+		void SetNumberOfVariationalBayesIterations(int N);
 		void SetBetaSpace(int space);
 		void SetStatisticalTest(int test);
 		void SetGroupDesigns(int *designs);
+		void SetExchangeabilityBlocks(int *blocks, int N);
+		void SetWholeBlockPermutation(bool W);
+		void SetVarianceGroups(int *groups, int N);
 		void SetInferenceMode(int mode);
 		void SetClusterDefiningThreshold(float threshold);
 		void SetPermutationMatrix(unsigned short int*);
@@ -163,6 +212,11 @@ class BROCCOLI_LIB
 		void SetSignMatrix(float*);
 		void SetPermutationFileUsage(bool);
 		void SetDoAllPermutations(bool);
+		void SetPermutationCheckpointFile(const char* filename);
+		void SetPermutationCheckpointInterval(size_t interval);
+		void SetResumePermutations(bool resume);
+		void AddPermutationCheckpointToMerge(const char* filename);
+		void SetPermutationRange(size_t first, size_t last);
 		void SetRawRegressors(bool);
 		void SetRawDesignMatrix(bool);
 		void SetCustomReferenceSlice(int);
@@ -173,6 +227,7 @@ class BROCCOLI_LIB
 		// Smoothing
 		void SetSmoothingFilters(float* smoothing_filter_x,float* smoothing_filter_y,float* smoothing_filter_z);
 		void SetSmoothingType(int);
+		void SetSmoothingMethod(int method);
 		void SetEPISmoothingAmount(float);
 		void SetARSmoothingAmount(float);
 		void SetApplySmoothing(bool);
@@ -195,6 +250,7 @@ class BROCCOLI_LIB
 		void SetChangeMotionCorrectionReferenceVolume(bool);
 		void SetMotionCorrectionReferenceVolume(float*);
 		void SetApplyMotionCorrection(bool);
+		void SetSingleInterpolationMNI(bool);
 		void SetCoarsestScaleT1MNI(int N);
 		void SetCoarsestScaleEPIT1(int N);
 		void SetMMT1ZCUT(int mm);
@@ -292,6 +348,7 @@ class BROCCOLI_LIB
 
 		// Output image registration
 		void SetOutputMotionParameters(float* output);
+		void SetOutputQualityMetrics(float* FD, float* DVARS, float* globalSignal, float* censored);
 		void SetOutputT1MNIRegistrationParameters(float* output);
 		void SetOutputEPIT1RegistrationParameters(float* output);
 		void SetOutputEPIMNIRegistrationParameters(float* output);
@@ -381,6 +438,7 @@ class BROCCOLI_LIB
 		int GetNumberOfSignificantlyActiveClusters();
 
 		int GetNumberOfICAComponents();
+		size_t GetNumberOfBrainVoxels();
 
 		// OpenCL
 
@@ -423,6 +481,7 @@ class BROCCOLI_LIB
 		double GetProcessingTimeDetrending();
 		double GetProcessingTimeStatisticalAnalysis();
 		double GetProcessingTimePermutationTest();
+		bool GetPermutationDistributionsComplete();
 
 		double GetProcessingTimeCopy();
 		double GetProcessingTimeConvolution();
@@ -431,6 +490,47 @@ class BROCCOLI_LIB
 		double GetProcessingTimeAH();
 		double GetProcessingTimeEquationSystem();
 		double GetProcessingTimeInterpolation();
+		double GetMCMCThroughput();
+
+		// Profiling of all enqueued OpenCL commands
+		void SetProfiling(bool profile);
+		void SetProfilingBufferSize(int size);
+		void ClearProfilingTimeline();
+		int GetNumberOfProfilingRecords();
+		double GetProfilingDeviceTime();
+		size_t GetProfilingTransferredBytes();
+		void PrintProfilingSummary();
+		bool SaveProfilingTimeline(const char* filename);
+
+		// Work-group size autotuning, the winners are saved to a per-device profile that OpenCLInitiate loads
+		void SetUseWorkGroupSizeProfile(bool use);
+		void SetAutotuneRepetitions(int repetitions);
+		bool AutotuneWorkGroupSizes(int DATA_W, int DATA_H, int DATA_D);
+		bool GetWorkGroupSizeProfileLoaded();
+		const char* GetWorkGroupSizeProfileFilename();
+		void PrintWorkGroupSizes();
+
+		// Size-bucketed pool of device buffers, released buffers are kept and reused by later requests of the same bucket
+		void SetUseDeviceBufferPool(bool use);
+		void SetDeviceBufferPoolLimit(size_t megabytes);
+		cl_mem CreateDeviceBuffer(cl_mem_flags flags, size_t size, cl_int* error);
+		void ReleaseDeviceBuffer(cl_mem buffer);
+		void TrimDeviceBufferPool();
+		size_t GetDeviceBufferPoolPeakMemory();
+		size_t GetDeviceBufferPoolCachedMemory();
+
+		// Storage order conversions of 4D datasets on the host, done in place with cache blocked tiles
+		void ConvertLayoutXYZTtoXYTZ(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+		void ConvertLayoutXYTZtoXYZT(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+		void ConvertLayoutXYZTtoTXYZ(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+		void ConvertLayoutTXYZtoXYZT(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+
+		// Device side reductions with one result per volume, REDUCTION_COMPONENTS floats per volume are written to h_Results
+		// (value and number of voxels, or x, y, z and total mass for REDUCTION_CENTER_OF_MASS), d_Mask can be NULL
+		void ReduceVolumes(float* h_Results, cl_mem d_Volumes, cl_mem d_Mask, int OPERATION, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t NUMBER_OF_VOLUMES);
+		cl_event EnqueueReduceVolumes(float* h_Results, cl_mem d_Volumes, cl_mem d_Mask, int OPERATION, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t NUMBER_OF_VOLUMES);
+		void FlipVolumesXYZTtoXYTZ(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+		void FlipVolumesXYTZtoXYZT(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
 
 		// Wrappers
 		void PerformRegistrationTwoVolumesWrapper();
@@ -471,8 +571,22 @@ class BROCCOLI_LIB
 		std::string GetBROCCOLIDirectory();
 
 		void CreateCombinedDisplacementField(float* h_Registration_Parameters, cl_mem d_Displacement_Field_X, cl_mem d_Displacement_Field_Y, cl_mem d_Displacement_Field_Z, size_t DATA_W, size_t DATA_H, size_t DATA_D);
+		void CreateVoxelTransformationMatrix(Eigen::MatrixXd & Matrix, float* h_Parameters, int DATA_W, int DATA_H, int DATA_D);
+		void CreateResolutionAndSizeMatrix(Eigen::MatrixXd & Matrix, int DATA_W, int DATA_H, int DATA_D, int NEW_DATA_W, int NEW_DATA_H, int NEW_DATA_D, float VOXEL_SIZE_X, float VOXEL_SIZE_Y, float VOXEL_SIZE_Z, float NEW_VOXEL_SIZE_X, float NEW_VOXEL_SIZE_Y, float NEW_VOXEL_SIZE_Z, int MM_Z_CUT);
+		void CopyTransformationMatrix(float* h_Matrix, Eigen::MatrixXd & Matrix);
+		void CreateEPIMNIVoxelTransformationMatrix(Eigen::MatrixXd & Matrix);
+		void CreateEPIMNIVoxelTransformationMatrix(float* h_Matrix);
+		void CreateCombinedCoordinateField(cl_mem d_Coordinate_Field_X, cl_mem d_Coordinate_Field_Y, cl_mem d_Coordinate_Field_Z, float* h_Matrix, cl_mem d_Displacement_Field_X, cl_mem d_Displacement_Field_Y, cl_mem d_Displacement_Field_Z, int DATA_W, int DATA_H, int DATA_D);
+		void CreateEPIMNICoordinateField(cl_mem d_Coordinate_Field_X, cl_mem d_Coordinate_Field_Y, cl_mem d_Coordinate_Field_Z);
+		void TransformVolumesCombined(cl_mem d_New_Volumes, cl_mem d_Volumes, cl_mem d_Coordinate_Field_X, cl_mem d_Coordinate_Field_Y, cl_mem d_Coordinate_Field_Z, int DATA_W, int DATA_H, int DATA_D, int NEW_DATA_W, int NEW_DATA_H, int NEW_DATA_D, int VOLUME_OFFSET, int NUMBER_OF_VOLUMES, int INTERPOLATION_MODE);
+		void TransformVolumesCombined(float* h_New_Volumes, cl_mem d_Volumes, cl_mem d_Coordinate_Field_X, cl_mem d_Coordinate_Field_Y, cl_mem d_Coordinate_Field_Z, int DATA_W, int DATA_H, int DATA_D, int NEW_DATA_W, int NEW_DATA_H, int NEW_DATA_D, int NUMBER_OF_VOLUMES, int INTERPOLATION_MODE);
+		void PrefilterBSpline(cl_mem d_Volumes, int DATA_W, int DATA_H, int DATA_D, int NUMBER_OF_VOLUMES);
+		bool IsHighOrderInterpolation(int INTERPOLATION_MODE);
+		int GetEstimationInterpolationMode(int INTERPOLATION_MODE);
+		void TransformVolumesHighOrder(cl_mem d_New_Volumes, cl_mem d_Volumes, float* h_Matrix, cl_mem d_Displacement_Field_X, cl_mem d_Displacement_Field_Y, cl_mem d_Displacement_Field_Z, int DATA_W, int DATA_H, int DATA_D, int NEW_DATA_W, int NEW_DATA_H, int NEW_DATA_D, int VOLUME_OFFSET, int NUMBER_OF_VOLUMES, int INTERPOLATION_MODE);
 
 		int Calculate3DIndex(int x, int y, int z, int DATA_W, int DATA_H);
+		cl_half ConvertFloatToHalf(float value);
 		void Clusterize(int* Cluster_Indices, int& MAX_CLUSTER_SIZE, float& MAX_CLUSTER_MASS, int& NUMBER_OF_CLUSTERS, float* Data, float Threshold, float* Mask, size_t DATA_W, size_t DATA_H, size_t DATA_D, int GET_VOXEL_LABELS, int GET_CLUSTER_MASS);
 		void ClusterizeOpenCL(cl_mem Cluster_Indices, cl_mem Cluster_Sizes, cl_mem Data, float Threshold, cl_mem Mask, int DATA_W, int DATA_H, int DATA_D, int NUMBER_OF_CONTRASTS);
 		void ClusterizeOpenCLTFCE(float& MAX_VALUE, cl_mem d_Mask, int DATA_W, int DATA_H, int DATA_D, float maxThreshold);
@@ -488,6 +602,14 @@ class BROCCOLI_LIB
 		void PerformRegistrationT1MNINoSkullstrip();
 		void SegmentEPIData();
 		void SegmentEPIData(cl_mem Volume);
+		void CreateEPIMask(cl_mem d_Mask, cl_mem d_Volume);
+		float CalculateEPIMaskThreshold(cl_mem d_Smoothed_Volume);
+		float CalculateOtsuThreshold(float* h_Volume, size_t N);
+		float CalculatePercentileThreshold(float* h_Volume, size_t N, float fraction);
+		void ErodeMask(cl_mem d_Mask, int iterations, int DATA_W, int DATA_H, int DATA_D);
+		void DilateMask(cl_mem d_Mask, int iterations, int DATA_W, int DATA_H, int DATA_D);
+		void KeepLargestConnectedComponent(float* h_Mask, int DATA_W, int DATA_H, int DATA_D);
+		void FillHolesInMask(float* h_Mask, int DATA_W, int DATA_H, int DATA_D);
 		void PerformSliceTimingCorrection();
 		void PerformSliceTimingCorrectionHost(float* h_Volumes);
 		void PerformMotionCorrection(cl_mem Volumes);
@@ -495,21 +617,33 @@ class BROCCOLI_LIB
 
 		void PerformRegression(cl_mem, cl_mem, size_t, size_t, size_t, size_t);
 		void PerformRegressionSlice(cl_mem, cl_mem, size_t, size_t, size_t, size_t, size_t);
+		void PerformNuisanceRegression(cl_mem, cl_mem, size_t, size_t, size_t, size_t);
+		void PerformNuisanceRegressionSlice(cl_mem, cl_mem, size_t, size_t, size_t, size_t, size_t);
 		void PerformDetrending(cl_mem, cl_mem, size_t, size_t, size_t, size_t);
 		void PerformDetrendingSlice(cl_mem, cl_mem, size_t, size_t, size_t, size_t, size_t);
 		void PerformDetrendingAndMotionRegression(cl_mem, cl_mem, size_t, size_t, size_t, size_t);
 		void PerformDetrendingAndMotionRegressionSlice(cl_mem, cl_mem, size_t, size_t, size_t, size_t, size_t);
 
 		void CalculateBetaWeightsAndContrastsFirstLevel(float* h_Volumes);
-		void CalculateBetaWeightsAndContrastsFirstLevelSlices(float* h_Volumes);
+		void CalculateBetaWeightsAndContrastsFirstLevelBlocks(float* h_Volumes);
 		cl_int CalculateStatisticalMapsGLMTTestFirstLevel(float *h_Volumes, int iterations);
-		void CalculateStatisticalMapsGLMTTestFirstLevelSlices(float* h_Volumes, int iterations);
+		void CalculateStatisticalMapsGLMTTestFirstLevelBlocks(float* h_Volumes, int iterations);
+		void CalculateStatisticalMapsGLMTTestFirstLevelRuns(float* h_Volumes, int iterations);
+		size_t GetLongestRun();
+		size_t CalculateFirstLevelBlockSize(size_t numberOfBrainVoxels, size_t bytesPerVoxel, size_t largestBytesPerVoxel);
+		void GetBrainVoxelIndices(std::vector<int>& brainVoxels);
+		void PackFirstLevelBlock(float* h_Block_Volumes, float* h_Block_Mask, float* h_Block_Voxel_Numbers, int* h_Block_Voxel_Indices, float* h_Volumes, std::vector<int>& brainVoxels, size_t firstVoxel, size_t voxelsInBlock, size_t BLOCK_SIZE);
+		void UploadFirstLevelBlock(cl_command_queue queue, cl_event* events, cl_mem d_Block_Volumes, cl_mem d_Block_Means, cl_mem d_Block_Mask, cl_mem d_Block_Voxel_Numbers, cl_mem d_Block_Voxel_Indices, float* h_Block_Volumes, cl_half* h_Block_Volumes_Half, float* h_Block_Means, float* h_Block_Mask, float* h_Block_Voxel_Numbers, int* h_Block_Voxel_Indices, float* h_Volumes, std::vector<int>& brainVoxels, size_t firstVoxel, size_t voxelsInBlock, size_t BLOCK_SIZE, float scale);
+		void CalculateStatisticalMapsGLMFirstLevelBlocks(float* h_Volumes, int iterations, int TEST_TYPE);
+		void ScatterBlockVolumes(cl_mem d_Volumes, cl_mem d_Block_Volumes, cl_mem d_Voxel_Indices, int NUMBER_OF_BLOCK_VOXELS, int BLOCK_W, int BLOCK_H, int NUMBER_OF_VOLUMES);
 		void CalculateStatisticalMapsGLMFTestFirstLevel(float *h_Volumes, int iterations);
-		void CalculateStatisticalMapsGLMFTestFirstLevelSlices(float* h_Volumes, int iterations);
+		void CalculateStatisticalMapsGLMFTestFirstLevelBlocks(float* h_Volumes, int iterations);
 		void CalculateStatisticalMapsGLMTTestSecondLevel(cl_mem Volumes, cl_mem Mask);
+		void CalculateStatisticalMapsGLMWelchSecondLevel(cl_mem Volumes, cl_mem Mask);
 		void CalculateStatisticalMapsGLMFTestSecondLevel(cl_mem Volumes, cl_mem Mask);
 
 		void CalculateStatisticalMapsGLMBayesianFirstLevel(float* h_Volumes);
+		void CalculateStatisticalMapsGLMBayesian(float* h_Volumes, float* h_X, float* h_Bayesian_Contrasts, float* h_X_Nuisance, int NUMBER_OF_REGRESSORS, int NUMBER_OF_NUISANCE_REGRESSORS, int NUMBER_OF_BAYESIAN_CONTRASTS);
 
 		void CalculateNumberOfBrainVoxels(cl_mem d_Mask, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void CreateVoxelNumbers(cl_mem d_Voxel_Numbers, cl_mem d_Mask, size_t DATA_W, size_t DATA_H, size_t DATA_D);
@@ -521,37 +655,62 @@ class BROCCOLI_LIB
 		void WhitenDesignMatricesTTestSlice(cl_mem d_xtxxt_GLM, cl_mem d_GLM_Scalars, float* h_X_GLM, float* h_Contrasts, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem d_Voxel_Numbers, size_t slice, size_t EPI_DATA_W, size_t EPI_DATA_H, size_t DATA_D, size_t EPI_DATA_T, size_t NUMBER_OF_GLM_REGRESSORS, size_t NUMBER_OF_INVALID_TIMEPOINTS, size_t NUMBER_OF_CONTRASTS);
 		void WhitenDesignMatricesFTest(cl_mem d_xtxxt_GLM, cl_mem d_GLM_Scalars, float* h_X_GLM, float* h_Contrasts, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem d_Voxel_Numbers, size_t EPI_DATA_W, size_t EPI_DATA_H, size_t EPI_DATA_D, size_t EPI_DATA_T, size_t NUMBER_OF_GLM_REGRESSORS, size_t NUMBER_OF_INVALID_TIMEPOINTS, size_t NUMBER_OF_CONTRASTS);
 		void WhitenDesignMatricesFTestSlice(cl_mem d_xtxxt_GLM, cl_mem d_GLM_Scalars, float* h_X_GLM, float* h_Contrasts, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem d_Voxel_Numbers, size_t slice, size_t EPI_DATA_W, size_t EPI_DATA_H, size_t EPI_DATA_D, size_t EPI_DATA_T, size_t NUMBER_OF_GLM_REGRESSORS, size_t NUMBER_OF_INVALID_TIMEPOINTS, size_t NUMBER_OF_CONTRASTS);
+		void WhitenDesignMatricesBatched(int MODE, cl_mem d_Output, cl_mem d_GLM_Scalars, float* h_X_GLM, float* h_Contrasts, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem d_Voxel_Numbers, size_t slice, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t NUMBER_OF_SLICES, size_t DATA_T, size_t NUMBER_OF_REGRESSORS, size_t NUMBER_OF_INVALID_TIMEPOINTS, size_t NUMBER_OF_CONTRASTS);
+		void SolveBatchedSystems(cl_mem d_Solutions, cl_mem d_Status, cl_mem d_Matrices, cl_mem d_Right_Hand_Sides, int METHOD, int M, int N, int NUMBER_OF_RIGHT_HAND_SIDES, int NUMBER_OF_SYSTEMS);
+		void SolveBatchedSystemsHost(float* h_Solutions, int* h_Status, const float* h_Matrices, const float* h_Right_Hand_Sides, int METHOD, int M, int N, int NUMBER_OF_RIGHT_HAND_SIDES, size_t NUMBER_OF_SYSTEMS);
 		
 		void PutWhitenedModelsIntoVolumes(cl_mem d_Mask, cl_mem d_xtxxt_GLM, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T, size_t NUMBER_OF_REGRESSORS);
 		void PutWhitenedModelsIntoVolumes2(cl_mem d_Mask, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, float* Regressors, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T, size_t NUMBER_OF_REGRESSORS);
 
 		void ApplyPermutationTestFirstLevel(float* h_fMRI_Volumes);
 		void ApplyPermutationTestSecondLevel();
+		void ApplyPermutationTestSecondLevelBatched();
 
 		// Permutation first level
-		void SetupPermutationTestFirstLevel();
+		bool SetupPermutationTestFirstLevel();
 		void CleanupPermutationTestFirstLevel();
 		void GeneratePermutationMatrixFirstLevel();
 		void PerformDetrendingPriorPermutation();
 		void PerformWhiteningPriorPermutations(cl_mem Whitened_volumes, cl_mem Volumes);
-		void GeneratePermutedVolumesFirstLevel(cl_mem Permuted_Volumes, cl_mem Whitened_Volumes, int permutation);
-		void CalculateStatisticalMapsFirstLevelPermutation(int contrast);
-		void CalculateStatisticalMapsGLMTTestFirstLevelPermutation(int contrast);
-		void CalculateStatisticalMapsGLMFTestFirstLevelPermutation();
+		void PerformWhiteningPriorPermutationsSlices(cl_mem Whitened_volumes, float* h_Volumes);
+		void EstimateAR4ModelsSlice(cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Volumes, cl_mem d_Mask, cl_mem c_Censored_Timepoints, int DATA_W, int DATA_H, int DATA_D, int DATA_T, int slice);
+		void ApplyWhiteningAR4Slice(cl_mem d_Whitened_Volumes, cl_mem d_Volumes, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem c_Censored_Timepoints, int DATA_W, int DATA_H, int DATA_T, int slice);
+		void ApplyWhiteningAR4SliceHalf(cl_mem d_Whitened_Volumes, cl_mem d_Volumes, cl_mem d_Means, cl_mem d_AR1_Estimates, cl_mem d_AR2_Estimates, cl_mem d_AR3_Estimates, cl_mem d_AR4_Estimates, cl_mem d_Mask, cl_mem c_Censored_Timepoints, int DATA_W, int DATA_H, int DATA_T, int slice, float inverseScale);
+		void CalculateStatisticalMapsFirstLevelPermutation(int contrast, int permutation);
+		void LoadPermutationVectorsFirstLevel(int permutation);
+		void CalculateStatisticalMapsGLMTTestFirstLevelPermutation(int contrast, int permutation);
+		void CalculateStatisticalMapsGLMFTestFirstLevelPermutation(int permutation);
 
 		// Permutation second level
 		void SetupPermutationTestSecondLevel(cl_mem Volumes, cl_mem Mask);
 		void CleanupPermutationTestSecondLevel();
+		void SetClusterizePermutationContrast(int contrast);
 		void GeneratePermutationMatrixSecondLevelTwoSample(int c);
 		void GeneratePermutationMatrixSecondLevelCorrelation(int c);
+		void GeneratePermutationMatrixSecondLevelBlocks(int c, bool twoSample);
+		void CalculateVarianceGroupWeights(float* h_Weights, unsigned short int* permutation, int contrast);
 		void GenerateSignMatrixSecondLevel();
 		void CalculateStatisticalMapsSecondLevelPermutation(int permutation, int contrast);
 		void CalculateStatisticalMapsMeanSecondLevelPermutation();
 		void CalculateStatisticalMapsGLMTTestSecondLevelPermutation();
+		void CalculateStatisticalMapsGLMWelchSecondLevelPermutation();
 		void CalculateStatisticalMapsGLMFTestSecondLevelPermutation();
 
 		void CalculatePermutationPValues(cl_mem Mask, int DATA_W, int DATA_H, int DATA_D);
 
+		// Checkpointing of permutation tests, level is 1 for first level and 2 for second level
+		size_t GetNumberOfCheckpointMaps(int level);
+		size_t GetNumberOfCheckpointPermutations(int level, size_t c);
+		float* GetCheckpointDistribution(int level, size_t c);
+		void* GetCheckpointPermutationVectors(int level, size_t c, size_t& bytes);
+		bool StartPermutationCheckpoint(int level);
+		void MergePermutationCheckpoints(int level);
+		bool ReadPermutationCheckpoint(const char* filename, int level, bool merge);
+		bool WritePermutationCheckpoint(int level);
+		bool PermutationToBeCalculated(size_t c, size_t p);
+		void PermutationCalculated(int level, size_t c, size_t p);
+		bool FinishPermutationCheckpoint(int level);
+
 		void ResetEigenMatrix(Eigen::MatrixXd &);
 		void ResetEigenMatrix(Eigen::MatrixXf &);
 		void IdentityEigenMatrix(Eigen::MatrixXd &);
@@ -600,6 +759,14 @@ class BROCCOLI_LIB
 		void PerformSmoothingNormalized(cl_mem d_Volumes, cl_mem d_Certainty, cl_mem d_Smoothed_Certainty, float* h_Smoothing_Filter_X, float* h_Smoothing_Filter_Y, float* h_Smoothing_Filter_Z, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
 		void PerformSmoothingNormalizedPermutation();
 
+		// Recursive Gaussian smoothing, the cost does not depend on the FWHM
+		bool UseRecursiveSmoothing(float smoothing_FWHM, float voxel_size_x, float voxel_size_y, float voxel_size_z);
+		void CalculateRecursiveGaussianCoefficients(float* coefficients, double sigma);
+		void RunRecursiveGaussian(cl_mem d_Smoothed_Volumes, cl_mem d_Volumes, cl_mem d_Certainty, cl_mem d_Smoothed_Certainty, cl_mem d_Temp, float* coefficients, int DATA_W, int DATA_H, int DATA_D, int t);
+		void PerformSmoothingRecursive(cl_mem d_Smoothed_Volumes, cl_mem d_Volumes, float smoothing_FWHM, float voxel_size_x, float voxel_size_y, float voxel_size_z, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
+		void PerformSmoothingNormalizedRecursive(cl_mem d_Smoothed_Volumes, cl_mem d_Volumes, cl_mem d_Certainty, cl_mem d_Smoothed_Certainty, float smoothing_FWHM, float voxel_size_x, float voxel_size_y, float voxel_size_z, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
+		void PerformSmoothingNormalizedHostRecursive(float* h_Volumes, cl_mem d_Certainty, cl_mem d_Smoothed_Certainty, float smoothing_FWHM, float voxel_size_x, float voxel_size_y, float voxel_size_z, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
+
 		//------------------------------------------------
 		// Functions for image registration
 		//------------------------------------------------
@@ -638,17 +805,28 @@ class BROCCOLI_LIB
 		void CleanupGLMFirstLevel();
 
 		void CalculateCenterOfMass(float &rx, float &ry, float &rz, cl_mem d_Volume, size_t DATA_W, size_t DATA_H, size_t DATA_D);
+		void CalculateCentersOfMass(float* h_Center_1, float* h_Center_2, cl_mem d_Volume_1, cl_mem d_Volume_2, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void CenterVolumeMass(cl_mem d_Volume, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void CenterVolumeMass(cl_mem d_Volume, float* h_Parameters, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void MatchVolumeMasses(cl_mem d_Volume_1, cl_mem d_Volume_2, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void MatchVolumeMasses(cl_mem d_Volume_1, cl_mem d_Volume_2, float* h_Parameters, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 
-		void FlipVolumesXYZTtoXYTZ(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
-		void FlipVolumesXYTZtoXYZT(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
+		void TransposeBlocksInPlace(float* h_Data, size_t ROWS, size_t COLS, size_t BLOCK_SIZE);
+		void TransposeMatrixTiled(float* h_Out, const float* h_In, size_t ROWS, size_t COLS);
+		void TransposeSlabs(float* h_Data, size_t SLAB_ROWS, size_t SLAB_COLS, size_t NUMBER_OF_SLABS);
 		void CopyCurrentfMRISliceToHost(float* h_Volumes, cl_mem d_Volumes, size_t slice, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
 		void CopyCurrentfMRISliceToDevice(cl_mem d_Volumes, float* h_Volumes, size_t slice, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T);
 
 		void CalculateGlobalMeans(float* h_Volumes);		
+		void TransformT1VolumeToEPI(float* h_EPI_Volume, float* h_T1_Volume_);
+		Eigen::MatrixXf CalculateCompCorComponents(float* h_Tissue_Map, float* h_Mask, int NUMBER_OF_COMPONENTS);
+		void PerformCompCor();
+		void CalculateFramewiseDisplacement(float* h_FD);
+		void CalculateGlobalSignalAndDVARS(float* h_Global, float* h_DVARS_, float* h_Volumes);
+		void PerformQualityControl();
+		bool IsCensoredTimepoint(size_t t);
+		void SetCensoredTimepointWeights(cl_mem c_Weights, size_t DATA_T);
+		void SetCensoredTimepointWeights(cl_mem c_Weights, size_t DATA_T, size_t FIRST_TIMEPOINT);
 
 		void SetMemory(cl_mem memory, float value, size_t N);
 		void SetMemoryDouble(cl_mem memory, double value, size_t N);
@@ -670,6 +848,7 @@ class BROCCOLI_LIB
 		void AddVolumes(cl_mem d_Result, cl_mem d_Volume_1, cl_mem d_Volume_2, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void SubtractVolumes(cl_mem d_Volume_1, cl_mem d_Volume_2, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		void SubtractVolumes(cl_mem d_Result, cl_mem d_Volume_1, cl_mem d_Volume_2, size_t DATA_W, size_t DATA_H, size_t DATA_D);
+		void EnqueueReduction(cl_mem d_Results, int RESULT_OFFSET, cl_mem d_Volumes, cl_mem d_Mask, int OPERATION, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t NUMBER_OF_VOLUMES);
 		float CalculateSum(cl_mem Volume, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 		float CalculateMax(cl_mem Volume, size_t DATA_W, size_t DATA_H, size_t DATA_D);
 
@@ -698,6 +877,8 @@ class BROCCOLI_LIB
 		void SetupDetrendingRegressors(int N);
 		void SetupDetrendingAndMotionRegressors(int N);
 		Eigen::MatrixXd SetupGLMRegressorsFirstLevel();
+		Eigen::MatrixXd SetupNuisanceRegressors();
+		int GetNumberOfDCTRegressors(int N);
 		void SetupTTestFirstLevel();
 		void SetupFTestFirstLevel();
 		void DemeanRegressor(float* Regressor, int N);
@@ -712,17 +893,52 @@ class BROCCOLI_LIB
 		void CreateHRF();
 		void ConvolveRegressorsWithHRF(float* Convolved_Regressors, float* Regressors, int NUMBER_OF_TIMEPOINTS, int NUMBER_OF_REGRESSORS);
 		void GenerateRegressorTemporalDerivatives(float * Regressors_With_Temporal_Derivatives, float* Regressors, int NUMBER_OF_TIMEPOINTS, int NUMBER_OF_REGRESSORS);
+		float GetSliceTimingReferenceTime();
+		void FFT1D(std::vector< std::complex<double> > & Data, bool inverse);
+		Eigen::VectorXd CreateCanonicalHRF(double dt, int LENGTH, double onset, double dispersion);
+		Eigen::MatrixXd CreateHRFBasisFunctions(double dt);
+		void CreateEventRegressors(float* Regressors);
 
 		void PrintMemoryStatus(const char* text);
 
+		// Enqueue functions, same arguments as the OpenCL functions, commands are recorded if profiling is on
+		cl_int EnqueueNDRangeKernel(cl_command_queue queue, cl_kernel kernel, cl_uint workDim, const size_t* globalWorkOffset, const size_t* globalWorkSize, const size_t* localWorkSize, cl_uint numberOfEvents, const cl_event* eventWaitList, cl_event* event);
+		cl_int EnqueueReadBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size, void* pointer, cl_uint numberOfEvents, const cl_event* eventWaitList, cl_event* event);
+		cl_int EnqueueWriteBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size, const void* pointer, cl_uint numberOfEvents, const cl_event* eventWaitList, cl_event* event);
+		cl_int EnqueueCopyBuffer(cl_command_queue queue, cl_mem source, cl_mem destination, size_t sourceOffset, size_t destinationOffset, size_t size, cl_uint numberOfEvents, const cl_event* eventWaitList, cl_event* event);
+		cl_int EnqueueCopyBufferToImage(cl_command_queue queue, cl_mem source, cl_mem destination, size_t sourceOffset, const size_t* destinationOrigin, const size_t* region, cl_uint numberOfEvents, const cl_event* eventWaitList, cl_event* event);
+
+		cl_event* AddProfilingRecord(int type, const char* name, cl_uint workDim, const size_t* globalWorkSize, const size_t* localWorkSize, size_t bytes);
+		void ResolveProfilingRecord(OpenCLProfilingRecord& record);
+		void ResolveProfilingRecords();
+
+		bool LoadWorkGroupSizeProfile();
+		bool SaveWorkGroupSizeProfile();
+		bool ValidLocalWorkSize(const size_t* localWorkSize);
+		void ApplyTunedLocalWorkSize(const char* name, size_t* localWorkSize);
+		bool NonseparableConvolutionVariantSupported(int variant);
+		cl_kernel CreateNonseparableConvolutionKernel(int variant, cl_int* error);
+		std::string GetProfileFilenamePart(std::string name);
+		void ApplyWorkGroupSizeProfile();
+		double GetMedianTime(std::vector<double>& times);
+		cl_int RunAutotuneCandidate(const char* name, cl_mem d_Result, cl_mem d_Volume_1, cl_mem d_Volume_2, cl_mem* d_q, cl_mem* d_AR_Estimates, cl_mem d_Volumes, cl_mem d_Whitened_Volumes, cl_mem c_Censored_Timepoints, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
+		double TimeAutotuneCandidate(const char* name, cl_mem d_Result, cl_mem d_Volume_1, cl_mem d_Volume_2, cl_mem* d_q, cl_mem* d_AR_Estimates, cl_mem d_Volumes, cl_mem d_Whitened_Volumes, cl_mem c_Censored_Timepoints, int DATA_W, int DATA_H, int DATA_D, int DATA_T);
+
+		size_t GetDeviceBufferPoolBucketSize(size_t size);
+		size_t GetDeviceBufferPoolLimit();
+
 		//------------------------------------------------
 		// Set functions
 		//------------------------------------------------
 
 		void SetGlobalAndLocalWorkSizesSeparableConvolution(int DATA_W, int DATA_H, int DATA_D);
+		void SetGlobalAndLocalWorkSizesRecursiveGaussian(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesNonSeparableConvolution(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesImageRegistration(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesStatisticalCalculations(int DATA_W, int DATA_H, int DATA_D);
+		void SetGlobalAndLocalWorkSizesSolveBatched(int NUMBER_OF_SYSTEMS);
+		void SetGlobalAndLocalWorkSizesBayesianVoxelList(int NUMBER_OF_VOXELS);
+		void SetGlobalAndLocalWorkSizesWhitenDesignMatrices(int DATA_W, int DATA_H, int DATA_D);
         void SetGlobalAndLocalWorkSizesSearchlight(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesInterpolateVolume(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesCopyVolumeToNew(int DATA_W, int DATA_H, int DATA_D);
@@ -731,6 +947,7 @@ class BROCCOLI_LIB
 		void SetGlobalAndLocalWorkSizesAddVolumes(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesCalculateSum(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesCalculateMax(int DATA_W, int DATA_H, int DATA_D);
+		void SetGlobalAndLocalWorkSizesReduceVolumes(size_t N, size_t NUMBER_OF_VOLUMES);
 		void SetGlobalAndLocalWorkSizesThresholdVolume(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesCalculateMagnitudes(int DATA_W, int DATA_H, int DATA_D);
 		void SetGlobalAndLocalWorkSizesClusterize(int DATA_W, int DATA_H, int DATA_D);
@@ -747,6 +964,7 @@ class BROCCOLI_LIB
 		//------------------------------------------------
 
 		size_t xBlocks, yBlocks, zBlocks;
+		size_t numberOfReductionGroups;
 		size_t programBinarySize, writtenElements;
 
 		int	NUMBER_OF_KERNEL_FILES;
@@ -770,6 +988,7 @@ class BROCCOLI_LIB
 
 		cl_ulong localMemorySize;
 		size_t globalMemorySize;
+		cl_ulong maxMemoryAllocationSize;
 		size_t maxThreadsPerBlock;
 		size_t maxThreadsPerDimension[3];
 
@@ -812,12 +1031,17 @@ class BROCCOLI_LIB
 		cl_kernel MemsetDoubleKernel;
 		cl_kernel MemsetIntKernel;
 		cl_kernel MemsetFloat2Kernel;
+		cl_kernel ScatterBlockVolumesKernel;
 		cl_kernel MultiplyVolumeKernel, MultiplyVolumesKernel, MultiplyVolumesOverwriteKernel, MultiplyVolumesOverwriteDoubleKernel;
 		cl_kernel AddVolumeKernel, AddVolumesKernel, AddVolumesOverwriteKernel;
 		cl_kernel SubtractVolumesKernel, SubtractVolumesOverwriteKernel, SubtractVolumesOverwriteDoubleKernel;
 		cl_kernel CalculateColumnSumsKernel, CalculateRowSumsKernel;
 		cl_kernel CalculateColumnMaxsKernel, CalculateRowMaxsKernel;
 		cl_kernel CalculateMaxAtomicKernel;
+		cl_kernel ReduceVolumesKernel, ReduceVolumesFinalKernel;
+		cl_kernel ErodeMaskKernel, DilateMaskKernel;
+		cl_kernel CreateCombinedCoordinateFieldKernel, InterpolateVolumesCombinedKernel;
+		cl_kernel BSplinePrefilterKernel;
 		cl_kernel ThresholdVolumeKernel;
 		cl_kernel RemoveMeanKernel;
 		cl_kernel SetStartClusterIndicesKernel;
@@ -836,6 +1060,7 @@ class BROCCOLI_LIB
 		// Convolution kernels
 		cl_kernel SeparableConvolutionRowsKernel, SeparableConvolutionColumnsKernel, SeparableConvolutionRodsKernel;
 		cl_kernel NonseparableConvolution3DComplexThreeFiltersKernel;
+		cl_kernel RecursiveGaussianRowsKernel, RecursiveGaussianColumnsKernel, RecursiveGaussianRodsKernel;
 
 		cl_kernel SliceTimingCorrectionKernel;
 
@@ -860,17 +1085,29 @@ class BROCCOLI_LIB
 		cl_kernel CalculateStatisticalMapsGLMTTestFirstLevelKernel, CalculateStatisticalMapsGLMFTestFirstLevelKernel;
 		cl_kernel CalculateStatisticalMapsGLMTTestFirstLevelSliceKernel, CalculateStatisticalMapsGLMFTestFirstLevelSliceKernel;
 		cl_kernel CalculateStatisticalMapsGLMTTestKernel, CalculateStatisticalMapsGLMFTestKernel, CalculateStatisticalMapsGLMBayesianKernel;
-		cl_kernel CalculateStatisticalMapsGLMTTestFirstLevelPermutationKernel,CalculateStatisticalMapsGLMFTestFirstLevelPermutationKernel;
 		cl_kernel CalculateStatisticalMapsMeanSecondLevelPermutationKernel, CalculateStatisticalMapsGLMTTestSecondLevelPermutationKernel,CalculateStatisticalMapsGLMFTestSecondLevelPermutationKernel;
 		cl_kernel CalculateStatisticalMapSearchlightKernel;
         cl_kernel RemoveLinearFitKernel, RemoveLinearFitSliceKernel;
-		cl_kernel EstimateAR4ModelsKernel, EstimateAR4ModelsSliceKernel, ApplyWhiteningAR4Kernel, ApplyWhiteningAR4SliceKernel, GeneratePermutedVolumesFirstLevelKernel;
+		cl_kernel EstimateAR4ModelsKernel, EstimateAR4ModelsSliceKernel, ApplyWhiteningAR4Kernel, ApplyWhiteningAR4SliceKernel;
+		cl_kernel StoreSliceHalfKernel;
+		cl_kernel SolveCholeskyBatchedKernel, SolveLDLBatchedKernel, SolveQRBatchedKernel;
+		cl_kernel WhitenDesignMatricesInverseKernel, WhitenDesignMatricesTTestKernel, WhitenDesignMatricesFTestKernel;
+		cl_kernel CalculateStatisticalMapsGLMTTestFirstLevelPermutationFusedKernel, CalculateStatisticalMapsGLMFTestFirstLevelPermutationFusedKernel;
+		cl_kernel CalculateStatisticalMapsGLMTTestFirstLevelPermutationFusedHalfKernel, CalculateStatisticalMapsGLMFTestFirstLevelPermutationFusedHalfKernel;
+		cl_kernel CalculateStatisticalMapsGLMBayesianVolumeKernel, CalculateStatisticalMapsGLMBayesianVoxelListKernel;
+		cl_kernel CalculateStatisticalMapsGLMVariationalBayesVolumeKernel, CalculateStatisticalMapsGLMVariationalBayesVoxelListKernel;
+		cl_kernel RemoveNuisanceRegressorsKernel, RemoveNuisanceRegressorsSliceKernel;
+		cl_kernel AccumulateWhitenedNormalEquationsKernel, CalculateStatisticalMapsGLMTTestNormalEquationsKernel;
+		cl_kernel CalculateNuisanceResidualSumsOfSquaresSecondLevelKernel, CalculateStatisticalMapsGLMTTestSecondLevelPermutationBatchedKernel;
+		cl_kernel CalculateStatisticalMapsGLMWelchSecondLevelPermutationKernel;
+		cl_kernel ApplyWhiteningAR4SliceHalfKernel, CalculateGLMResidualsSliceHalfKernel;
 		cl_kernel CalculatePermutationPValuesVoxelLevelInferenceKernel, CalculatePermutationPValuesClusterExtentInferenceKernel, CalculatePermutationPValuesClusterMassInferenceKernel;
 
 		// Create kernel errors
 
 		// Help kernels
 		cl_int createKernelErrorMemset, createKernelErrorMemsetDouble, createKernelErrorMemsetInt, createKernelErrorMemsetFloat2;
+		cl_int createKernelErrorScatterBlockVolumes;
 		cl_int createKernelErrorMultiplyVolume;
 		cl_int createKernelErrorMultiplyVolumes;
 		cl_int createKernelErrorMultiplyVolumesOverwrite;
@@ -902,11 +1139,16 @@ class BROCCOLI_LIB
 		// Convolution kernels
 		cl_int createKernelErrorSeparableConvolutionRows, createKernelErrorSeparableConvolutionColumns, createKernelErrorSeparableConvolutionRods;
 		cl_int createKernelErrorNonseparableConvolution3DComplexThreeFilters;
+		cl_int createKernelErrorRecursiveGaussianRows, createKernelErrorRecursiveGaussianColumns, createKernelErrorRecursiveGaussianRods;
 		cl_int createKernelErrorCalculateColumnSums;
 		cl_int createKernelErrorCalculateRowSums;
 		cl_int createKernelErrorCalculateColumnMaxs;
 		cl_int createKernelErrorCalculateRowMaxs;
 		cl_int createKernelErrorCalculateMaxAtomic;
+		cl_int createKernelErrorReduceVolumes, createKernelErrorReduceVolumesFinal;
+		cl_int createKernelErrorErodeMask, createKernelErrorDilateMask;
+		cl_int createKernelErrorCreateCombinedCoordinateField, createKernelErrorInterpolateVolumesCombined;
+		cl_int createKernelErrorBSplinePrefilter;
 		cl_int createKernelErrorThresholdVolume;
 
 		cl_int createKernelErrorSliceTimingCorrection;
@@ -933,11 +1175,21 @@ class BROCCOLI_LIB
 		cl_int createKernelErrorCalculateStatisticalMapsGLMTTestFirstLevel, createKernelErrorCalculateStatisticalMapsGLMFTestFirstLevel;
 		cl_int createKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelSlice, createKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelSlice;
 		cl_int createKernelErrorCalculateStatisticalMapsGLMTTest, createKernelErrorCalculateStatisticalMapsGLMFTest, createKernelErrorCalculateStatisticalMapsGLMBayesian;
-		cl_int createKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutation, createKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutation;
 		cl_int createKernelErrorCalculateStatisticalMapsMeanSecondLevelPermutation, createKernelErrorCalculateStatisticalMapsGLMTTestSecondLevelPermutation, createKernelErrorCalculateStatisticalMapsGLMFTestSecondLevelPermutation;
         cl_int createKernelErrorCalculateStatisticalMapSearchlight;
         cl_int createKernelErrorEstimateAR4Models, createKernelErrorEstimateAR4ModelsSlice, createKernelErrorApplyWhiteningAR4, createKernelErrorApplyWhiteningAR4Slice;
-		cl_int createKernelErrorGeneratePermutedVolumesFirstLevel;
+		cl_int createKernelErrorStoreSliceHalf;
+		cl_int createKernelErrorSolveCholeskyBatched, createKernelErrorSolveLDLBatched, createKernelErrorSolveQRBatched;
+		cl_int createKernelErrorWhitenDesignMatricesInverse, createKernelErrorWhitenDesignMatricesTTest, createKernelErrorWhitenDesignMatricesFTest;
+		cl_int createKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutationFused, createKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutationFused;
+		cl_int createKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutationFusedHalf, createKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutationFusedHalf;
+		cl_int createKernelErrorCalculateStatisticalMapsGLMBayesianVolume, createKernelErrorCalculateStatisticalMapsGLMBayesianVoxelList;
+		cl_int createKernelErrorCalculateStatisticalMapsGLMVariationalBayesVolume, createKernelErrorCalculateStatisticalMapsGLMVariationalBayesVoxelList;
+		cl_int createKernelErrorRemoveNuisanceRegressors, createKernelErrorRemoveNuisanceRegressorsSlice;
+		cl_int createKernelErrorAccumulateWhitenedNormalEquations, createKernelErrorCalculateStatisticalMapsGLMTTestNormalEquations;
+		cl_int createKernelErrorCalculateNuisanceResidualSumsOfSquaresSecondLevel, createKernelErrorCalculateStatisticalMapsGLMTTestSecondLevelPermutationBatched;
+		cl_int createKernelErrorCalculateStatisticalMapsGLMWelchSecondLevelPermutation;
+		cl_int createKernelErrorApplyWhiteningAR4SliceHalf, createKernelErrorCalculateGLMResidualsSliceHalf;
 		cl_int createKernelErrorRemoveLinearFit, createKernelErrorRemoveLinearFitSlice;
 		cl_int createKernelErrorCalculatePermutationPValuesVoxelLevelInference, createKernelErrorCalculatePermutationPValuesClusterExtentInference, createKernelErrorCalculatePermutationPValuesClusterMassInference;
 
@@ -968,6 +1220,7 @@ class BROCCOLI_LIB
 
 		// Help kernels
 		cl_int runKernelErrorMemset, runKernelErrorMemsetDouble, runKernelErrorMemsetInt, runKernelErrorMemsetFloat2;
+		cl_int runKernelErrorScatterBlockVolumes;
 		cl_int runKernelErrorMultiplyVolume;
 		cl_int runKernelErrorMultiplyVolumes;
 		cl_int runKernelErrorMultiplyVolumesOverwrite;
@@ -999,11 +1252,16 @@ class BROCCOLI_LIB
 		// Convolution kernels
 		cl_int runKernelErrorSeparableConvolutionRows, runKernelErrorSeparableConvolutionColumns, runKernelErrorSeparableConvolutionRods;
 		cl_int runKernelErrorNonseparableConvolution3DComplexThreeFilters;
+		cl_int runKernelErrorRecursiveGaussianRows, runKernelErrorRecursiveGaussianColumns, runKernelErrorRecursiveGaussianRods;
 		cl_int runKernelErrorCalculateColumnSums;
 		cl_int runKernelErrorCalculateRowSums;
 		cl_int runKernelErrorCalculateColumnMaxs;
 		cl_int runKernelErrorCalculateRowMaxs;
 		cl_int runKernelErrorCalculateMaxAtomic;
+		cl_int runKernelErrorReduceVolumes, runKernelErrorReduceVolumesFinal;
+		cl_int runKernelErrorErodeMask, runKernelErrorDilateMask;
+		cl_int runKernelErrorCreateCombinedCoordinateField, runKernelErrorInterpolateVolumesCombined;
+		cl_int runKernelErrorBSplinePrefilter;
 		cl_int runKernelErrorThresholdVolume;
 
 		cl_int runKernelErrorSliceTimingCorrection;
@@ -1030,11 +1288,21 @@ class BROCCOLI_LIB
 		cl_int runKernelErrorCalculateStatisticalMapsGLMTTestFirstLevel, runKernelErrorCalculateStatisticalMapsGLMFTestFirstLevel;
 		cl_int runKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelSlice, runKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelSlice;
 		cl_int runKernelErrorCalculateStatisticalMapsGLMTTest, runKernelErrorCalculateStatisticalMapsGLMFTest, runKernelErrorCalculateStatisticalMapsGLMBayesian;
-		cl_int runKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutation, runKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutation;
 		cl_int runKernelErrorCalculateStatisticalMapsMeanSecondLevelPermutation, runKernelErrorCalculateStatisticalMapsGLMTTestSecondLevelPermutation, runKernelErrorCalculateStatisticalMapsGLMFTestSecondLevelPermutation;
         cl_int runKernelErrorCalculateStatisticalMapSearchlight;
         cl_int runKernelErrorEstimateAR4Models, runKernelErrorEstimateAR4ModelsSlice, runKernelErrorApplyWhiteningAR4, runKernelErrorApplyWhiteningAR4Slice;
-		cl_int runKernelErrorGeneratePermutedVolumesFirstLevel;
+		cl_int runKernelErrorStoreSliceHalf;
+		cl_int runKernelErrorSolveCholeskyBatched, runKernelErrorSolveLDLBatched, runKernelErrorSolveQRBatched;
+		cl_int runKernelErrorWhitenDesignMatricesInverse, runKernelErrorWhitenDesignMatricesTTest, runKernelErrorWhitenDesignMatricesFTest;
+		cl_int runKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutationFused, runKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutationFused;
+		cl_int runKernelErrorCalculateStatisticalMapsGLMTTestFirstLevelPermutationFusedHalf, runKernelErrorCalculateStatisticalMapsGLMFTestFirstLevelPermutationFusedHalf;
+		cl_int runKernelErrorCalculateStatisticalMapsGLMBayesianVolume, runKernelErrorCalculateStatisticalMapsGLMBayesianVoxelList;
+		cl_int runKernelErrorCalculateStatisticalMapsGLMVariationalBayesVolume, runKernelErrorCalculateStatisticalMapsGLMVariationalBayesVoxelList;
+		cl_int runKernelErrorRemoveNuisanceRegressors, runKernelErrorRemoveNuisanceRegressorsSlice;
+		cl_int runKernelErrorAccumulateWhitenedNormalEquations, runKernelErrorCalculateStatisticalMapsGLMTTestNormalEquations;
+		cl_int runKernelErrorCalculateNuisanceResidualSumsOfSquaresSecondLevel, runKernelErrorCalculateStatisticalMapsGLMTTestSecondLevelPermutationBatched;
+		cl_int runKernelErrorCalculateStatisticalMapsGLMWelchSecondLevelPermutation;
+		cl_int runKernelErrorApplyWhiteningAR4SliceHalf, runKernelErrorCalculateGLMResidualsSliceHalf;
 		cl_int runKernelErrorRemoveLinearFit, runKernelErrorRemoveLinearFitSlice;
 		cl_int runKernelErrorCalculatePermutationPValuesVoxelLevelInference, runKernelErrorCalculatePermutationPValuesClusterExtentInference, runKernelErrorCalculatePermutationPValuesClusterMassInference;
 
@@ -1053,6 +1321,9 @@ class BROCCOLI_LIB
 		size_t localWorkSizeSeparableConvolutionColumns[3];
 		size_t localWorkSizeSeparableConvolutionRods[3];
 		size_t localWorkSizeNonseparableConvolution3DComplex[3];
+		size_t localWorkSizeRecursiveGaussianRows[3];
+		size_t localWorkSizeRecursiveGaussianColumns[3];
+		size_t localWorkSizeRecursiveGaussianRods[3];
 		size_t localWorkSizeCalculatePhaseDifferencesAndCertainties[3];
 		size_t localWorkSizeCalculatePhaseGradients[3];
 		size_t localWorkSizeCalculateAMatrixAndHVector2DValuesX[3];
@@ -1073,6 +1344,8 @@ class BROCCOLI_LIB
 		size_t localWorkSizeCalculateColumnMaxs[3];
 		size_t localWorkSizeCalculateRowMaxs[3];
 		size_t localWorkSizeCalculateMaxAtomic[3];
+		size_t localWorkSizeReduceVolumes[3];
+		size_t localWorkSizeReduceVolumesFinal[3];
 		size_t localWorkSizeThresholdVolume[3];
 		size_t localWorkSizeCalculateBetaWeightsGLM[3];
 		size_t localWorkSizeCalculateStatisticalMapsGLM[3];
@@ -1080,7 +1353,9 @@ class BROCCOLI_LIB
 		size_t localWorkSizeRemoveLinearFit[3];
 		size_t localWorkSizeEstimateAR4Models[3];
 		size_t localWorkSizeApplyWhiteningAR4[3];
-		size_t localWorkSizeGeneratePermutedVolumesFirstLevel[3];
+		size_t localWorkSizeSolveBatched[3];
+		size_t localWorkSizeBayesianVoxelList[3];
+		size_t localWorkSizeWhitenDesignMatrices[3];
 		size_t localWorkSizeCalculateTensorNorms[3];
 		size_t localWorkSizeCalculateAMatricesAndHVectors[3];
 		size_t localWorkSizeCalculateDisplacementAndCertaintyUpdate[3];
@@ -1094,6 +1369,9 @@ class BROCCOLI_LIB
 		size_t globalWorkSizeSeparableConvolutionColumns[3];
 		size_t globalWorkSizeSeparableConvolutionRods[3];
 		size_t globalWorkSizeNonseparableConvolution3DComplex[3];
+		size_t globalWorkSizeRecursiveGaussianRows[3];
+		size_t globalWorkSizeRecursiveGaussianColumns[3];
+		size_t globalWorkSizeRecursiveGaussianRods[3];
 		size_t globalWorkSizeCalculatePhaseDifferencesAndCertainties[3];
 		size_t globalWorkSizeCalculatePhaseGradients[3];
 		size_t globalWorkSizeCalculateAMatrixAndHVector2DValuesX[3];
@@ -1114,6 +1392,8 @@ class BROCCOLI_LIB
 		size_t globalWorkSizeCalculateColumnMaxs[3];
 		size_t globalWorkSizeCalculateRowMaxs[3];
 		size_t globalWorkSizeCalculateMaxAtomic[3];
+		size_t globalWorkSizeReduceVolumes[3];
+		size_t globalWorkSizeReduceVolumesFinal[3];
 		size_t globalWorkSizeThresholdVolume[3];
 		size_t globalWorkSizeCalculateBetaWeightsGLM[3];
 		size_t globalWorkSizeCalculateStatisticalMapsGLM[3];
@@ -1121,7 +1401,9 @@ class BROCCOLI_LIB
 		size_t globalWorkSizeRemoveLinearFit[3];
 		size_t globalWorkSizeEstimateAR4Models[3];
 		size_t globalWorkSizeApplyWhiteningAR4[3];
-		size_t globalWorkSizeGeneratePermutedVolumesFirstLevel[3];
+		size_t globalWorkSizeSolveBatched[3];
+		size_t globalWorkSizeBayesianVoxelList[3];
+		size_t globalWorkSizeWhitenDesignMatrices[3];
 		size_t globalWorkSizeCalculateTensorNorms[3];
 		size_t globalWorkSizeCalculateAMatricesAndHVectors[3];
 		size_t globalWorkSizeCalculateDisplacementAndCertaintyUpdate[3];
@@ -1145,6 +1427,7 @@ class BROCCOLI_LIB
 		bool APPLY_SLICE_TIMING_CORRECTION;
 		bool APPLY_MOTION_CORRECTION;
 		bool APPLY_SMOOTHING;
+		bool SINGLE_INTERPOLATION_MNI;
 
 		bool WRITE_INTERPOLATED_T1;
 		bool WRITE_ALIGNED_T1_MNI_LINEAR;
@@ -1194,6 +1477,30 @@ class BROCCOLI_LIB
 
 		double processing_times[20];
 
+		// Profiling ring buffer, the oldest records are overwritten when it is full
+		bool PROFILING;
+		int PROFILING_BUFFER_SIZE;
+		size_t numberOfProfilingRecords;
+		std::vector<OpenCLProfilingRecord> profilingRecords;
+
+		// Work-group sizes from the autotuner, indexed by the name of the work size function
+		bool USE_WORK_GROUP_SIZE_PROFILE;
+		bool WORK_GROUP_SIZE_PROFILE_LOADED;
+		int AUTOTUNE_REPETITIONS;
+		int NONSEPARABLE_CONVOLUTION_VARIANT;
+		int TUNED_NONSEPARABLE_CONVOLUTION_VARIANT;
+		std::string workGroupSizeProfileFilename;
+		std::map<std::string, std::vector<size_t> > tunedLocalWorkSizes;
+
+		// Device buffer pool, free buffers are indexed by flags and bucket size, leased buffers by handle
+		bool USE_DEVICE_BUFFER_POOL;
+		size_t DEVICE_BUFFER_POOL_LIMIT;
+		std::map<std::pair<cl_mem_flags, size_t>, std::vector<cl_mem> > freeDeviceBuffers;
+		std::map<cl_mem, std::pair<cl_mem_flags, size_t> > leasedDeviceBuffers;
+		size_t pooledBufferRequests, pooledBufferHits, pooledBufferCreations;
+		size_t pooledMemoryInUse, pooledMemoryCached;
+		size_t peakPooledMemoryInUse, peakPooledMemory;
+
 		int SLICE_ORDER;
 		int SLICE_CUSTOM_REF;
 
@@ -1228,10 +1535,21 @@ class BROCCOLI_LIB
 		// Smoothing variables
 		int	SMOOTHING_FILTER_SIZE;
 		int SMOOTHING_TYPE;
+		int SMOOTHING_METHOD;
 		float EPI_Smoothing_FWHM;
 		float AR_Smoothing_FWHM;
 		bool AUTO_MASK;
 
+		// EPI mask variables
+		int EPI_MASK_METHOD;
+		float EPI_MASK_PERCENTILE_FRACTION;
+		float EPI_MASK_SMOOTHING;
+		bool EPI_MASK_FROM_MEAN;
+		bool EPI_MASK_LARGEST_COMPONENT;
+		bool EPI_MASK_FILL_HOLES;
+		int EPI_MASK_EROSIONS;
+		int EPI_MASK_DILATIONS;
+
 		// Statistical analysis variables
 		size_t NUMBER_OF_SUBJECTS;
 		int *NUMBER_OF_SUBJECTS_IN_GROUP1;
@@ -1247,8 +1565,14 @@ class BROCCOLI_LIB
 		size_t USE_TEMPORAL_DERIVATIVES;
 		bool RAW_REGRESSORS;
 		bool RAW_DESIGNMATRIX;
+		bool EVENT_DESIGN;
+		int NUMBER_OF_EVENT_TYPES;
+		int HRF_BASIS;
+		int NUMBER_OF_BASIS_FUNCTIONS;
+		float BASIS_FUNCTION_LENGTH;
 		bool BAYESIAN;
 		bool REGRESS_ONLY;
+		bool STREAM_RUNS;
 		bool PREPROCESSING_ONLY;
 		bool BETAS_ONLY;
 		bool CONTRASTS_ONLY;
@@ -1256,6 +1580,14 @@ class BROCCOLI_LIB
 		size_t REGRESS_MOTION;
 		size_t REGRESS_GLOBALMEAN;
 		size_t REGRESS_CONFOUNDS;
+		float HIGHPASS_CUTOFF;
+		int NUMBER_OF_COMPCOR_COMPONENTS;
+		int NUMBER_OF_COMPCOR_REGRESSORS;
+		float COMPCOR_THRESHOLD;
+		float FD_THRESHOLD;
+		float DVARS_THRESHOLD;
+		int NUMBER_OF_CENSORED_TIMEPOINTS;
+		int NUMBER_OF_NUISANCE_BASIS_VECTORS;
 		bool PERMUTE_FIRST_LEVEL;
 		float CLUSTER_DEFINING_THRESHOLD;
 		int NUMBER_OF_CLUSTERS;
@@ -1266,8 +1598,14 @@ class BROCCOLI_LIB
 		float SIGNIFICANCE_THRESHOLD;
 		int STATISTICAL_TEST;
 		int *GROUP_DESIGNS;
+		int *h_Exchangeability_Blocks;
+		int NUMBER_OF_EXCHANGEABILITY_BLOCKS;
+		bool WHOLE_BLOCK_PERMUTATION;
+		int *h_Variance_Groups;
+		int NUMBER_OF_VARIANCE_GROUPS;
 		size_t NUMBER_OF_BRAIN_VOXELS;
 		size_t NUMBER_OF_INVALID_TIMEPOINTS;
+		size_t FIRST_LEVEL_BLOCK_SIZE;
 		bool USE_PERMUTATION_FILE;
 
 		// ICA variables
@@ -1279,12 +1617,34 @@ class BROCCOLI_LIB
 
 		// Random permutation variables
 		size_t NUMBER_OF_PERMUTATIONS;
+		int STORAGE_PRECISION;
 		size_t *NUMBER_OF_PERMUTATIONS_PER_CONTRAST;
+		bool BATCH_CONTRAST_PERMUTATIONS;
+		bool CORRECT_ACROSS_CONTRASTS;
+
+		// Permutation checkpoints, one flag per permutation and statistical map tells if it has been calculated
+		std::string permutationCheckpointFilename;
+		std::vector<std::string> permutationCheckpointsToMerge;
+		size_t PERMUTATION_CHECKPOINT_INTERVAL;
+		size_t PERMUTATIONS_SINCE_CHECKPOINT;
+		size_t FIRST_PERMUTATION, LAST_PERMUTATION;
+		bool RESUME_PERMUTATIONS;
+		bool PERMUTATION_DISTRIBUTIONS_COMPLETE;
+		std::vector< std::vector<unsigned char> > calculatedPermutations;
 		int NUMBER_OF_SIGNIFICANTLY_ACTIVE_VOXELS;
 		int NUMBER_OF_SIGNIFICANTLY_ACTIVE_CLUSTERS;
 
 		// MCMC variables
 		int NUMBER_OF_MCMC_ITERATIONS;
+		int BAYESIAN_EXECUTION_MODE;
+		cl_uint MCMC_SEED;
+		double MCMC_THROUGHPUT;
+
+		// Variational Bayes variables
+		int BAYESIAN_METHOD;
+		int VB_AR_ORDER;
+		int NUMBER_OF_VB_ITERATIONS;
+		float VB_TOLERANCE;
 
 		//--------------------------------------------------
 		// Host pointers
@@ -1293,6 +1653,8 @@ class BROCCOLI_LIB
 		// Data pointers
 		float		*h_fMRI_Volumes;
 		float		*h_fMRI_Volumes_MNI;
+		float		*h_fMRI_Volumes_Uncorrected;
+		float		*h_Motion_Correction_Parameters;
 		float		*h_MNI_Brain_Mask;
 		float		*h_Mask;
 		float		*h_EPI_Mask;
@@ -1375,12 +1737,17 @@ class BROCCOLI_LIB
 		// Statistical analysis pointers
 		float		*hrf;
 		int		 HRF_LENGTH;
+		int		*h_Number_Of_Events;
+		float		*h_Event_Onsets, *h_Event_Durations, *h_Event_Amplitudes;
 		float       	*h_Contrasts, *h_Contrasts_In;
 		float		*h_X_GLM_Out, *h_X_GLM_In, *h_X_GLM_Confounds, *h_xtxxt_GLM_In, *h_ctxtxc_GLM_In;
         float       *h_Correct_Classes_In, *h_d_In;
 		float		*h_X_GLM, *h_X_GLM_With_Temporal_Derivatives, *h_X_GLM_Convolved, *h_xtxxt_GLM, *h_xtxxt_GLM_Out, *h_ctxtxc_GLM;
 		float 		*h_Global_Mean;
+		float		*h_WM_Map_T1, *h_CSF_Map_T1, *h_CompCor_Components;
 		float		*h_Censored_Timepoints, *h_Censored_Volumes;
+		float		*h_Framewise_Displacement, *h_DVARS, *h_Global_Signal, *h_Censoring_Weights;
+		float		*h_Framewise_Displacement_Out, *h_DVARS_Out, *h_Global_Signal_Out, *h_Censored_Out;
 		float       	*h_Beta_Volumes_MNI, *h_Beta_Volumes_EPI, *h_Beta_Volumes_T1;
 		float       	*h_Beta_Volumes_No_Whitening_MNI, *h_Beta_Volumes_No_Whitening_EPI, *h_Beta_Volumes_No_Whitening_T1;
 		float       	*h_Contrast_Volumes_MNI, *h_Contrast_Volumes_EPI, *h_Contrast_Volumes_T1;
@@ -1490,6 +1857,7 @@ class BROCCOLI_LIB
 		cl_mem		d_Residuals;
 		cl_mem		d_Residual_Variances, d_Residual_Variances_T1, d_Residual_Variances_MNI;
 		cl_mem		c_Censored_Timepoints, c_Censored_Volumes;
+		cl_mem		c_Nuisance_Basis;
 		cl_mem		d_P_Values, d_P_Values_T1, d_P_Values_MNI;
 		cl_mem		c_Permutation_Distribution;
 
@@ -1506,6 +1874,8 @@ class BROCCOLI_LIB
 		cl_mem 		d_Temp_fMRI_Volumes_2;
 
 		cl_mem		c_Permutation_Vector;
+		cl_mem		c_Variance_Weights;
+		cl_mem		d_Permutation_Vectors;
 		cl_mem		c_Sign_Vector;
 
 		int	hostMemoryAllocations, hostMemoryDeallocations;
@@ -1514,4 +1884,22 @@ class BROCCOLI_LIB
 
 };
 
+// Scoped lease of a pooled device buffer, the buffer is returned to the pool when the lease goes out of scope
+class DeviceBufferLease
+{
+	public:
+
+		DeviceBufferLease(BROCCOLI_LIB* owner, cl_mem_flags flags, size_t size);
+		~DeviceBufferLease();
+
+		cl_mem buffer;
+
+	private:
+
+		BROCCOLI_LIB* owner;
+
+		DeviceBufferLease(const DeviceBufferLease&);
+		DeviceBufferLease& operator=(const DeviceBufferLease&);
+};
+
 #endif
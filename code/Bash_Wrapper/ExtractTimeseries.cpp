@@ -23,6 +23,8 @@
 #include <iostream>
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <vector>
 
 #include <limits.h>
 #include <unistd.h>
@@ -74,6 +76,7 @@ int main(int argc, char ** argv)
     float           VOXEL_SIZE_X, VOXEL_SIZE_Y, VOXEL_SIZE_Z;
 
 	bool			CHANGE_OUTPUT_FILENAME = false;
+	bool			LABELS = false;
 
     //-----------------------
     // Output parameters
@@ -92,6 +95,7 @@ int main(int argc, char ** argv)
         printf("ExtractTimeseries input.nii mask.nii [options]\n\n");
         printf("Options:\n\n");
         printf(" -output      Set filename of text file  \n");
+        printf(" -labels      Treat the mask as a label volume (e.g. from MakeROI) and write one column per label > 0 \n");
         printf("\n\n");
         
         return EXIT_SUCCESS;
@@ -136,6 +140,11 @@ int main(int argc, char ** argv)
             outputFilename = argv[i+1];
             i += 2;
         }
+        else if (strcmp(input,"-labels") == 0)
+        {
+			LABELS = true;
+            i += 1;
+        }
         else
         {
             printf("Unrecognized option! %s \n",argv[i]);
@@ -314,38 +323,103 @@ int main(int argc, char ** argv)
 
     //------------------------
 
-	float* h_Timeseries = (float*)malloc(DATA_T * sizeof(float));
+	// Find all labels, each label gets one column
+	std::map<int,int> labelToColumn;
+	std::vector<int> labels;
+	if (LABELS)
+	{
+		for (size_t i = 0; i < DATA_W * DATA_H * DATA_D; i++)
+		{
+			int label = (int)round(h_Mask[i]);
+			if (label > 0)
+			{
+				labelToColumn[label] = 0;
+			}
+		}
 
-	for (int t = 0; t < DATA_T; t++)
+		// Columns in increasing label order
+		for (std::map<int,int>::iterator it = labelToColumn.begin(); it != labelToColumn.end(); it++)
+		{
+			it->second = (int)labels.size();
+			labels.push_back(it->first);
+		}
+
+		if (labels.size() == 0)
+		{
+			printf("No labels > 0 found in the mask, aborting!\n");
+			FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+			FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		labels.push_back(1);
+	}
+
+	size_t NUMBER_OF_COLUMNS = labels.size();
+
+	float* h_Timeseries = (float*)malloc(DATA_T * NUMBER_OF_COLUMNS * sizeof(float));
+	std::vector<float> NUMBER_OF_VOXELS(NUMBER_OF_COLUMNS, 0.0f);
+
+	for (size_t i = 0; i < DATA_T * NUMBER_OF_COLUMNS; i++)
 	{
-		h_Timeseries[t] = 0.0f;
+		h_Timeseries[i] = 0.0f;
 	}
 
-	// Calculate average time series in mask
-	float NUMBER_OF_VOXELS = 0.0f;
+	// Calculate average time series in mask, or in each label
 	for (int x = 0; x < DATA_W; x++)
 	{
 		for (int y = 0; y < DATA_H; y++)
 		{
 			for (int z = 0; z < DATA_D; z++)
 			{
-				if ( h_Mask[x + y * DATA_W + z * DATA_W * DATA_H] == 1.0f )
+				float value = h_Mask[x + y * DATA_W + z * DATA_W * DATA_H];
+				int column = -1;
+				if (LABELS)
 				{
-					NUMBER_OF_VOXELS += 1.0f;
+					int label = (int)round(value);
+					if (label > 0)
+					{
+						column = labelToColumn[label];
+					}
+				}
+				else if (value == 1.0f)
+				{
+					column = 0;
+				}
+
+				if (column >= 0)
+				{
+					NUMBER_OF_VOXELS[column] += 1.0f;
 					for (int t = 0; t < DATA_T; t++)
 					{
-						h_Timeseries[t] += h_Volumes[x + y * DATA_W + z * DATA_W * DATA_H + t * DATA_W * DATA_H * DATA_D];
+						h_Timeseries[column + t * NUMBER_OF_COLUMNS] += h_Volumes[x + y * DATA_W + z * DATA_W * DATA_H + t * DATA_W * DATA_H * DATA_D];
 					}
 				}
 			}
 		}
 	}
 
-	printf("There are %i voxels in the mask\n",(int)NUMBER_OF_VOXELS);
+	if (LABELS)
+	{
+		printf("Found %i labels, columns are in the order \n",(int)NUMBER_OF_COLUMNS);
+		for (size_t c = 0; c < NUMBER_OF_COLUMNS; c++)
+		{
+			printf("Column %i: label %i, %i voxels\n",(int)c + 1,labels[c],(int)NUMBER_OF_VOXELS[c]);
+		}
+	}
+	else
+	{
+		printf("There are %i voxels in the mask\n",(int)NUMBER_OF_VOXELS[0]);
+	}
 
 	for (int t = 0; t < DATA_T; t++)
 	{
-		h_Timeseries[t] /= NUMBER_OF_VOXELS;
+		for (size_t c = 0; c < NUMBER_OF_COLUMNS; c++)
+		{
+			h_Timeseries[c + t * NUMBER_OF_COLUMNS] /= NUMBER_OF_VOXELS[c];
+		}
 	}
 
     //------------------------
@@ -368,7 +442,15 @@ int main(int argc, char ** argv)
         timeseries.precision(6);
         for (size_t t = 0; t < DATA_T; t++)
         {
-            timeseries << h_Timeseries[t] << std::setw(2) << std::endl;
+			for (size_t c = 0; c < NUMBER_OF_COLUMNS; c++)
+			{
+	            timeseries << h_Timeseries[c + t * NUMBER_OF_COLUMNS] << std::setw(2);
+				if (c < (NUMBER_OF_COLUMNS - 1))
+				{
+					timeseries << " ";
+				}
+			}
+            timeseries << std::endl;
         }
         timeseries.close();
     }
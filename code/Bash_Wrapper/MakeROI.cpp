@@ -24,6 +24,10 @@
 #include <fstream>
 #include <iomanip>
 
+#include <sstream>
+#include <vector>
+#include <math.h>
+
 #include <limits.h>
 #include <unistd.h>
 
@@ -35,6 +39,293 @@
 #define CHECK_EXISTING_FILE true
 #define DONT_CHECK_EXISTING_FILE false
 
+#define OVERLAP_FIRST 0
+#define OVERLAP_LAST 1
+#define OVERLAP_NEAREST 2
+#define OVERLAP_EXCLUDE 3
+
+// A spherical (or, for anisotropic voxels, ellipsoidal) ROI, all values in voxels
+struct SphereROI
+{
+	float x, y, z;
+	float rx, ry, rz;
+	float label;
+};
+
+// Converts a world space (mm) coordinate to voxel coordinates, prefer the sform if it is set
+void WorldToVoxel(nifti_image* inputNifti, float x, float y, float z, float& vx, float& vy, float& vz)
+{
+	mat44 worldToVoxel = (inputNifti->sform_code > 0) ? inputNifti->sto_ijk : inputNifti->qto_ijk;
+
+	vx = worldToVoxel.m[0][0] * x + worldToVoxel.m[0][1] * y + worldToVoxel.m[0][2] * z + worldToVoxel.m[0][3];
+	vy = worldToVoxel.m[1][0] * x + worldToVoxel.m[1][1] * y + worldToVoxel.m[1][2] * z + worldToVoxel.m[1][3];
+	vz = worldToVoxel.m[2][0] * x + worldToVoxel.m[2][1] * y + worldToVoxel.m[2][2] * z + worldToVoxel.m[2][3];
+}
+
+// Reads a coordinate table, one ROI per row as "x y z [radius] [label]", lines starting with # are ignored
+bool ReadCoordinateFile(std::vector<SphereROI>& rois, const char* filename, nifti_image* inputNifti, bool mmCoordinates, bool mmRadius, float defaultRadius, bool defaultRadiusSet, float VOXEL_SIZE_X, float VOXEL_SIZE_Y, float VOXEL_SIZE_Z)
+{
+	std::ifstream file(filename);
+	if (!file.good())
+	{
+		printf("Could not open coordinate file %s !\n",filename);
+		return false;
+	}
+
+	std::string line;
+	int row = 0;
+	while (std::getline(file,line))
+	{
+		row++;
+
+		size_t start = line.find_first_not_of(" \t\r");
+		if ( (start == std::string::npos) || (line[start] == '#') )
+		{
+			continue;
+		}
+
+		std::istringstream values(line);
+		float v[5];
+		int N = 0;
+		while ( (N < 5) && (values >> v[N]) )
+		{
+			N++;
+		}
+
+		if (N < 3)
+		{
+			printf("Row %i in coordinate file %s has fewer than three values!\n",row,filename);
+			return false;
+		}
+
+		float radius = (N >= 4) ? v[3] : defaultRadius;
+		if ( (N < 4) && !defaultRadiusSet )
+		{
+			printf("Row %i in coordinate file %s has no radius, and no default radius was given with -radius or -radiusv!\n",row,filename);
+			return false;
+		}
+		if (radius <= 0.0f)
+		{
+			printf("Radius must be > 0, row %i in coordinate file %s !\n",row,filename);
+			return false;
+		}
+
+		SphereROI roi;
+		if (mmCoordinates)
+		{
+			WorldToVoxel(inputNifti, v[0], v[1], v[2], roi.x, roi.y, roi.z);
+		}
+		else
+		{
+			roi.x = v[0];
+			roi.y = v[1];
+			roi.z = v[2];
+		}
+
+		if (mmRadius)
+		{
+			roi.rx = radius / VOXEL_SIZE_X;
+			roi.ry = radius / VOXEL_SIZE_Y;
+			roi.rz = radius / VOXEL_SIZE_Z;
+		}
+		else
+		{
+			roi.rx = radius;
+			roi.ry = radius;
+			roi.rz = radius;
+		}
+
+		roi.label = (N >= 5) ? v[4] : (float)(rois.size() + 1);
+		if (roi.label <= 0.0f)
+		{
+			printf("Labels must be > 0, row %i in coordinate file %s !\n",row,filename);
+			return false;
+		}
+
+		rois.push_back(roi);
+	}
+
+	file.close();
+	return true;
+}
+
+// Range of voxel indices covered by a ROI along one axis
+void GetROIRange(int& start, int& stop, float center, float radius, int DATA_SIZE)
+{
+	// Small tolerance to keep voxels exactly on the surface, like distance <= radius
+	radius += 0.0001f;
+	start = (int)ceil(center - radius);
+	stop = (int)floor(center + radius);
+	if (start < 0)
+		start = 0;
+	if (stop > (DATA_SIZE - 1))
+		stop = DATA_SIZE - 1;
+}
+
+// Rasterises all ROIs into one label volume. Each thread owns whole slices and only visits
+// the bounding boxes of the ROIs intersecting its slice, so overlaps are resolved without races
+void RasteriseROIsLabels(float* h_Labels, std::vector<SphereROI>& rois, int DATA_W, int DATA_H, int DATA_D, int OVERLAP)
+{
+	int NUMBER_OF_ROIS = (int)rois.size();
+
+	// Bucket the ROIs by slice
+	std::vector< std::vector<int> > roisPerSlice(DATA_D);
+	for (int r = 0; r < NUMBER_OF_ROIS; r++)
+	{
+		int z0, z1;
+		GetROIRange(z0, z1, rois[r].z, rois[r].rz, DATA_D);
+		for (int z = z0; z <= z1; z++)
+		{
+			roisPerSlice[z].push_back(r);
+		}
+	}
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int z = 0; z < DATA_D; z++)
+	{
+		float* labels = &h_Labels[z * DATA_W * DATA_H];
+		for (int i = 0; i < DATA_W * DATA_H; i++)
+		{
+			labels[i] = 0.0f;
+		}
+
+		if (roisPerSlice[z].size() == 0)
+		{
+			continue;
+		}
+
+		// Normalized squared distance to the ROI center (nearest) or number of ROIs covering the voxel (exclude)
+		std::vector<float> sliceTemp;
+		if (OVERLAP == OVERLAP_NEAREST)
+		{
+			sliceTemp.assign(DATA_W * DATA_H, 2.0f);
+		}
+		else if (OVERLAP == OVERLAP_EXCLUDE)
+		{
+			sliceTemp.assign(DATA_W * DATA_H, 0.0f);
+		}
+
+		for (size_t n = 0; n < roisPerSlice[z].size(); n++)
+		{
+			SphereROI& roi = rois[roisPerSlice[z][n]];
+
+			float dz = ((float)z - roi.z) / roi.rz;
+			float remainingZ = 1.0001f - dz * dz;
+			if (remainingZ < 0.0f)
+			{
+				continue;
+			}
+
+			int y0, y1;
+			GetROIRange(y0, y1, roi.y, roi.ry * sqrt(remainingZ), DATA_H);
+			for (int y = y0; y <= y1; y++)
+			{
+				float dy = ((float)y - roi.y) / roi.ry;
+				float remainingY = remainingZ - dy * dy;
+				if (remainingY < 0.0f)
+				{
+					continue;
+				}
+
+				// Only the voxels inside the sphere are visited along x
+				int x0, x1;
+				GetROIRange(x0, x1, roi.x, roi.rx * sqrt(remainingY), DATA_W);
+				for (int x = x0; x <= x1; x++)
+				{
+					int i = x + y * DATA_W;
+
+					if (OVERLAP == OVERLAP_FIRST)
+					{
+						if (labels[i] == 0.0f)
+						{
+							labels[i] = roi.label;
+						}
+					}
+					else if (OVERLAP == OVERLAP_LAST)
+					{
+						labels[i] = roi.label;
+					}
+					else if (OVERLAP == OVERLAP_NEAREST)
+					{
+						float dx = ((float)x - roi.x) / roi.rx;
+						float distance = dx * dx + dy * dy + dz * dz;
+						if (distance < sliceTemp[i])
+						{
+							sliceTemp[i] = distance;
+							labels[i] = roi.label;
+						}
+					}
+					else if (OVERLAP == OVERLAP_EXCLUDE)
+					{
+						sliceTemp[i] += 1.0f;
+						labels[i] = roi.label;
+					}
+				}
+			}
+		}
+
+		// Remove voxels that belong to more than one ROI
+		if (OVERLAP == OVERLAP_EXCLUDE)
+		{
+			for (int i = 0; i < DATA_W * DATA_H; i++)
+			{
+				if (sliceTemp[i] > 1.0f)
+				{
+					labels[i] = 0.0f;
+				}
+			}
+		}
+	}
+}
+
+// Rasterises each ROI into its own binary volume of a 4D stack
+void RasteriseROIsStack(float* h_Volumes, std::vector<SphereROI>& rois, int DATA_W, int DATA_H, int DATA_D)
+{
+	int NUMBER_OF_ROIS = (int)rois.size();
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int r = 0; r < NUMBER_OF_ROIS; r++)
+	{
+		float* volume = &h_Volumes[(size_t)r * DATA_W * DATA_H * DATA_D];
+		for (size_t i = 0; i < (size_t)DATA_W * DATA_H * DATA_D; i++)
+		{
+			volume[i] = 0.0f;
+		}
+
+		SphereROI& roi = rois[r];
+
+		int z0, z1;
+		GetROIRange(z0, z1, roi.z, roi.rz, DATA_D);
+		for (int z = z0; z <= z1; z++)
+		{
+			float dz = ((float)z - roi.z) / roi.rz;
+			float remainingZ = 1.0001f - dz * dz;
+			if (remainingZ < 0.0f)
+			{
+				continue;
+			}
+
+			int y0, y1;
+			GetROIRange(y0, y1, roi.y, roi.ry * sqrt(remainingZ), DATA_H);
+			for (int y = y0; y <= y1; y++)
+			{
+				float dy = ((float)y - roi.y) / roi.ry;
+				float remainingY = remainingZ - dy * dy;
+				if (remainingY < 0.0f)
+				{
+					continue;
+				}
+
+				int x0, x1;
+				GetROIRange(x0, x1, roi.x, roi.rx * sqrt(remainingY), DATA_W);
+				for (int x = x0; x <= x1; x++)
+				{
+					volume[x + y * DATA_W + z * DATA_W * DATA_H] = 1.0f;
+				}
+			}
+		}
+	}
+}
 
 
 int main(int argc, char ** argv)
@@ -93,6 +384,13 @@ int main(int argc, char ** argv)
 	bool			MMCOORDINATE = false;
 	bool			VOXELSCOORDINATE = false;
 
+	const char*		COORDINATE_FILE = NULL;
+	bool			MMCOORDINATEFILE = false;
+	bool			VOXELSCOORDINATEFILE = false;
+
+	bool			WRITE_STACK = false;
+	int				OVERLAP = OVERLAP_FIRST;
+
     //-----------------------
     // Output parameters
     
@@ -113,6 +411,12 @@ int main(int argc, char ** argv)
         printf(" -coordinatev     Center of ROI (x,y,z), in voxels  \n");
         printf(" -radius          Radius of ROI, in millimeters \n");
         printf(" -radiusv         Radius of ROI, in voxels \n");
+        printf(" -coordinatefile  Text file with one ROI per row, x y z [radius] [label], coordinates in mm (world space) \n");
+        printf(" -coordinatefilev Text file with one ROI per row, x y z [radius] [label], coordinates in voxels \n");
+        printf("                  The radius column uses the unit of -radius / -radiusv (mm by default), which also gives the default radius \n");
+        printf("                  All ROIs are written to one label volume, labels default to the row number \n");
+        printf(" -stack           Write the ROIs from the coordinate file as a 4D volume, one binary ROI per volume \n");
+        printf(" -overlap         How to label voxels covered by several ROIs: first, last, nearest or exclude (default first) \n");
 		printf(" -output      	  Set filename of nifti file  \n");
         printf("\n\n");
         
@@ -231,6 +535,61 @@ int main(int argc, char ** argv)
             }
             i += 2;
         }        
+        else if ( (strcmp(input,"-coordinatefile") == 0) || (strcmp(input,"-coordinatefilev") == 0) )
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read filename after %s !\n",input);
+                return EXIT_FAILURE;
+			}
+
+			if (strcmp(input,"-coordinatefile") == 0)
+			{
+				MMCOORDINATEFILE = true;
+			}
+			else
+			{
+				VOXELSCOORDINATEFILE = true;
+			}
+            COORDINATE_FILE = argv[i+1];
+            i += 2;
+        }
+        else if (strcmp(input,"-stack") == 0)
+        {
+			WRITE_STACK = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-overlap") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after -overlap !\n");
+                return EXIT_FAILURE;
+			}
+
+			if (strcmp(argv[i+1],"first") == 0)
+			{
+				OVERLAP = OVERLAP_FIRST;
+			}
+			else if (strcmp(argv[i+1],"last") == 0)
+			{
+				OVERLAP = OVERLAP_LAST;
+			}
+			else if (strcmp(argv[i+1],"nearest") == 0)
+			{
+				OVERLAP = OVERLAP_NEAREST;
+			}
+			else if (strcmp(argv[i+1],"exclude") == 0)
+			{
+				OVERLAP = OVERLAP_EXCLUDE;
+			}
+			else
+			{
+			    printf("Overlap policy must be first, last, nearest or exclude! You provided %s \n",argv[i+1]);
+                return EXIT_FAILURE;
+			}
+            i += 2;
+        }
         else if (strcmp(input,"-output") == 0)
         {
 			CHANGE_OUTPUT_FILENAME = true;
@@ -253,19 +612,23 @@ int main(int argc, char ** argv)
     
     double startTime = GetWallTime();
 
-    if (!MMCOORDINATE && !VOXELSCOORDINATE)
+    if (!MMCOORDINATE && !VOXELSCOORDINATE && (COORDINATE_FILE == NULL))
     {
-        printf("Have to define center in mm or in voxels!\n");
+        printf("Have to define center in mm or in voxels, or provide a coordinate file!\n");
         return EXIT_FAILURE;
     }
-    if (MMCOORDINATE && VOXELSCOORDINATE)
+    if ( (MMCOORDINATE + VOXELSCOORDINATE + MMCOORDINATEFILE + VOXELSCOORDINATEFILE) > 1 )
     {
-        printf("Cannot define center in both mm and in voxels!\n");
+        printf("Can only use one of -coordinate, -coordinatev, -coordinatefile and -coordinatefilev!\n");
+        return EXIT_FAILURE;
+    }
+    if (WRITE_STACK && (COORDINATE_FILE == NULL))
+    {
+        printf("-stack can only be used together with a coordinate file!\n");
         return EXIT_FAILURE;
     }
 
-
-    if (!MMRADIUS && !VOXELSRADIUS)
+    if (!MMRADIUS && !VOXELSRADIUS && (COORDINATE_FILE == NULL))
     {
         printf("Have to define radius in mm or in voxels!\n");
         return EXIT_FAILURE;
@@ -302,16 +665,6 @@ int main(int argc, char ** argv)
     DATA_D = inputData->nz;
     DATA_T = inputData->nt;
 
-	XCOORDINATE = (float)DATA_W - XCOORDINATE - 1.0f;
-	YCOORDINATE = (float)DATA_H - YCOORDINATE - 1.0f;
-
-	if (VOXELSCOORDINATE)
-	{
-		//XCOORDINATEV = (float)DATA_W - XCOORDINATE - 1.0f;
-		//YCOORDINATEV = (float)DATA_H - YCOORDINATE - 1.0f;
-		//ZCOORDINATE -= 1.0f;
-	}
-
     // Get voxel sizes
     VOXEL_SIZE_X = inputData->dx;
     VOXEL_SIZE_Y = inputData->dy;
@@ -401,60 +754,96 @@ int main(int argc, char ** argv)
 
     //------------------------
 
-	if (MMRADIUS)
+	// Collect all ROIs, in voxel coordinates
+	std::vector<SphereROI> rois;
+
+	if (COORDINATE_FILE != NULL)
 	{
-		for (int x = 0; x < DATA_W; x++)
+		if (!ReadCoordinateFile(rois, COORDINATE_FILE, inputData, MMCOORDINATEFILE, !VOXELSRADIUS, VOXELSRADIUS ? RADIUSV : RADIUS, MMRADIUS || VOXELSRADIUS, VOXEL_SIZE_X, VOXEL_SIZE_Y, VOXEL_SIZE_Z))
 		{
-			for (int y = 0; y < DATA_H; y++)
-			{
-				for (int z = 0; z < DATA_D; z++)
-				{
-					float distance = sqrt( ((float) x - XCOORDINATE)*((float) x - XCOORDINATE)*VOXEL_SIZE_X*VOXEL_SIZE_X + ((float) y - YCOORDINATE)*((float) y - YCOORDINATE)*VOXEL_SIZE_Y*VOXEL_SIZE_Y + ((float) z - ZCOORDINATE)*((float) z - ZCOORDINATE)*VOXEL_SIZE_Z*VOXEL_SIZE_Z   );
-					if ( distance <= RADIUS )
-					{
-						h_Volume[x + y * DATA_W + z * DATA_W * DATA_H] = 1.0f;
-					}
-					else
-					{
-						h_Volume[x + y * DATA_W + z * DATA_W * DATA_H] = 0.0f;
-					}
-				}
-			}
+	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+	        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+			return EXIT_FAILURE;
+		}
+
+		if (rois.size() == 0)
+		{
+			printf("No ROIs found in coordinate file %s !\n",COORDINATE_FILE);
+	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+	        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+			return EXIT_FAILURE;
+		}
+
+		if (PRINT)
+		{
+			printf("Read %i ROIs from %s \n",(int)rois.size(),COORDINATE_FILE);
 		}
 	}
-	else if (VOXELSRADIUS)
+	else
 	{
-		for (int x = 0; x < DATA_W; x++)
+		SphereROI roi;
+		if (MMCOORDINATE)
 		{
-			for (int y = 0; y < DATA_H; y++)
-			{
-				for (int z = 0; z < DATA_D; z++)
-				{
-					float distance = sqrt( ((float) x - XCOORDINATE)*((float) x - XCOORDINATE) + ((float) y - YCOORDINATE)*((float) y - YCOORDINATE) + ((float) z - ZCOORDINATE)*((float) z - ZCOORDINATE) );
-					if ( distance <= RADIUSV )
-					{
-						h_Volume[x + y * DATA_W + z * DATA_W * DATA_H] = 1.0f;
-					}
-					else
-					{
-						h_Volume[x + y * DATA_W + z * DATA_W * DATA_H] = 0.0f;
-					}
-				}
-			}
+			WorldToVoxel(inputData, XCOORDINATE, YCOORDINATE, ZCOORDINATE, roi.x, roi.y, roi.z);
 		}
+		else
+		{
+			roi.x = XCOORDINATEV;
+			roi.y = YCOORDINATEV;
+			roi.z = ZCOORDINATEV;
+		}
+
+		if (MMRADIUS)
+		{
+			roi.rx = RADIUS / VOXEL_SIZE_X;
+			roi.ry = RADIUS / VOXEL_SIZE_Y;
+			roi.rz = RADIUS / VOXEL_SIZE_Z;
+		}
+		else
+		{
+			roi.rx = RADIUSV;
+			roi.ry = RADIUSV;
+			roi.rz = RADIUSV;
+		}
+		roi.label = 1.0f;
+		rois.push_back(roi);
+	}
+
+	size_t NUMBER_OF_OUTPUT_VOLUMES = WRITE_STACK ? rois.size() : 1;
+
+	if (WRITE_STACK)
+	{
+		// The input volume is too small to hold one volume per ROI
+		AllocateMemory(h_Volume, DATA_SIZE * NUMBER_OF_OUTPUT_VOLUMES, allMemoryPointers, numberOfMemoryPointers, allNiftiImages, numberOfNiftiImages, allocatedHostMemory, "ROI_STACK");
 	}
 
+	startTime = GetWallTime();
 
+	if (WRITE_STACK)
+	{
+		RasteriseROIsStack(h_Volume, rois, DATA_W, DATA_H, DATA_D);
+	}
+	else
+	{
+		RasteriseROIsLabels(h_Volume, rois, DATA_W, DATA_H, DATA_D, OVERLAP);
+	}
+
+	endTime = GetWallTime();
+
+	if (VERBOS)
+ 	{
+		printf("It took %f seconds to create the ROIs\n",(float)(endTime - startTime));
+	}
 
     //------------------------
          
     // Write results to file            
 
     nifti_image *outputNifti = nifti_copy_nim_info(inputData);
-    outputNifti->nt = 1;	
-    outputNifti->dim[0] = 3;
-    outputNifti->dim[4] = 1;
-    outputNifti->nvox = DATA_W * DATA_H * DATA_D;
+    outputNifti->nt = NUMBER_OF_OUTPUT_VOLUMES;	
+    outputNifti->dim[0] = WRITE_STACK ? 4 : 3;
+    outputNifti->dim[4] = NUMBER_OF_OUTPUT_VOLUMES;
+    outputNifti->nvox = DATA_W * DATA_H * DATA_D * NUMBER_OF_OUTPUT_VOLUMES;
     allNiftiImages[numberOfNiftiImages] = outputNifti;
 	numberOfNiftiImages++;
 
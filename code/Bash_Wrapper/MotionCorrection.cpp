@@ -76,6 +76,7 @@ int main(int argc, char ** argv)
     // Default parameters
     int             MOTION_CORRECTION_FILTER_SIZE = 7; 
     int             NUMBER_OF_ITERATIONS_FOR_MOTION_CORRECTION = 5;
+    int             INTERPOLATION_MODE = LINEAR;
     int             OPENCL_PLATFORM = 0;
     int             OPENCL_DEVICE = 0;
     int             NUMBER_OF_MOTION_CORRECTION_PARAMETERS = 6;    
@@ -122,6 +123,7 @@ int main(int argc, char ** argv)
         printf(" -device             The OpenCL device to use for the specificed platform (default 0) \n");
         printf(" -referencevolume    Give a reference volume to align all other volumes to (default false) \n");        
         printf(" -iterations         Number of iterations for the motion correction algorithm (default 5) \n");        
+        printf(" -interpolation      The interpolation to use for the corrected volumes, 1 = trilinear, 3 = cubic B-spline, 4 = Lanczos (default 1) \n");
         printf(" -output             Set output filename (default input_mc.nii) \n");
         printf(" -quiet              Don't print anything to the terminal (default false) \n");
         printf(" -verbose            Print extra stuff (default false) \n");
@@ -236,6 +238,28 @@ int main(int argc, char ** argv)
             }
             i += 2;
         }
+        else if (strcmp(input,"-interpolation") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after -interpolation !\n");
+                return EXIT_FAILURE;
+			}
+
+            INTERPOLATION_MODE = (int)strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("Interpolation mode must be an integer! You provided %s \n",argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+			if ( (INTERPOLATION_MODE != LINEAR) && (INTERPOLATION_MODE != BSPLINE) && (INTERPOLATION_MODE != LANCZOS) )
+            {
+			    printf("Interpolation mode has to be 1, 3 or 4!\n");
+                return EXIT_FAILURE;
+			}
+			i += 2;
+        }
         else if (strcmp(input,"-debug") == 0)
         {
             DEBUG = true;
@@ -675,6 +699,7 @@ int main(int argc, char ** argv)
         BROCCOLI.SetImageRegistrationFilterSize(MOTION_CORRECTION_FILTER_SIZE);
         BROCCOLI.SetLinearImageRegistrationFilters(h_Quadrature_Filter_1_Real, h_Quadrature_Filter_1_Imag, h_Quadrature_Filter_2_Real, h_Quadrature_Filter_2_Imag, h_Quadrature_Filter_3_Real, h_Quadrature_Filter_3_Imag);
         BROCCOLI.SetNumberOfIterationsForMotionCorrection(NUMBER_OF_ITERATIONS_FOR_MOTION_CORRECTION);
+        BROCCOLI.SetInterpolationMode(INTERPOLATION_MODE);
         
         BROCCOLI.SetOutputMotionParameters(h_Motion_Parameters);
       
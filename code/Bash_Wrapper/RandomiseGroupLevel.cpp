@@ -41,6 +41,43 @@ double factorial(unsigned long int n)
     return (n == 1 || n == 0) ? 1.0 : round( sqrt(2.0*3.14*(double)n) * pow( ((double)n / 2.7183), double(n) ) );
 }
 
+// Reads one label per subject (e.g. exchangeability blocks or variance groups) and renumbers the labels as 0, 1, 2, ...
+bool ReadSubjectLabels(const char* filename, std::vector<int>& labels, int& numberOfLabels, size_t NUMBER_OF_SUBJECTS)
+{
+	std::ifstream file;
+	file.open(filename);
+	if (!file.good())
+	{
+		file.close();
+		printf("Could not open %s, aborting! \n",filename);
+		return false;
+	}
+
+	std::vector<double> uniqueLabels;
+	labels.resize(NUMBER_OF_SUBJECTS);
+	for (size_t s = 0; s < NUMBER_OF_SUBJECTS; s++)
+	{
+		double temp;
+		if (!(file >> temp))
+		{
+			file.close();
+			printf("Could not read one value per subject from %s, aborting! \n",filename);
+			return false;
+		}
+
+		std::vector<double>::iterator it = std::find(uniqueLabels.begin(), uniqueLabels.end(), temp);
+		labels[s] = (int)(it - uniqueLabels.begin());
+		if (it == uniqueLabels.end())
+		{
+			uniqueLabels.push_back(temp);
+		}
+	}
+	file.close();
+
+	numberOfLabels = (int)uniqueLabels.size();
+	return true;
+}
+
 int main(int argc, char **argv)
 {
     //-----------------------
@@ -106,6 +143,11 @@ int main(int argc, char **argv)
 	const char* 	PERMUTATION_INPUT_FILE;
 	const char* 	PERMUTATION_VALUES_FILE;
 	const char* 	PERMUTATION_VECTORS_FILE;
+	const char*		CHECKPOINT_FILE;
+	size_t			CHECKPOINT_INTERVAL = 100;
+	size_t			FIRST_PERMUTATION = 1;
+	size_t			LAST_PERMUTATION = 0;
+	std::vector<const char*> MERGE_CHECKPOINT_FILES;
 
 	bool FOUND_DESIGN = false;
 	bool FOUND_CONTRASTS = false;
@@ -120,6 +162,21 @@ int main(int argc, char **argv)
 	bool WRITE_PERMUTATION_VALUES = false;
 	bool WRITE_PERMUTATION_VECTORS = false;
 	bool DO_ALL_PERMUTATIONS = false;
+	bool USE_CHECKPOINT = false;
+	bool RESUME_PERMUTATIONS = false;
+	bool USE_PERMUTATION_RANGE = false;
+	bool PERMUTATIONS_COMPLETE = true;
+	bool BATCH_CONTRASTS = false;
+	bool FWE_CONTRASTS = false;
+	bool USE_EXCHANGEABILITY_BLOCKS = false;
+	bool WHOLE_BLOCK_PERMUTATION = false;
+	bool USE_VARIANCE_GROUPS = false;
+	const char*		EXCHANGEABILITY_BLOCKS_FILE;
+	const char*		VARIANCE_GROUPS_FILE;
+	std::vector<int> EXCHANGEABILITY_BLOCKS;
+	std::vector<int> VARIANCE_GROUPS;
+	int NUMBER_OF_EXCHANGEABILITY_BLOCKS = 0;
+	int NUMBER_OF_VARIANCE_GROUPS = 0;
 	int	 NUMBER_OF_STATISTICAL_MAPS = 1;
 
 	for (int i = 0; i < 1000; i++)
@@ -166,6 +223,16 @@ int main(int argc, char **argv)
 		printf(" -writepermutationvalues    Write all the permutation values to a text file \n");
 		printf(" -writepermutations         Write all the random permutations (or sign flips) to a text file \n");
 		printf(" -permutationfile           Use a specific permutation file or sign flipping file (e.g. from FSL) \n");
+		printf(" -checkpoint                Save the progress of the permutation test to a file \n");
+		printf(" -checkpointinterval        Number of permutations between saving the checkpoint (default 100) \n");
+		printf(" -resume                    Continue the permutation test from the checkpoint, if it exists \n");
+		printf(" -permutationrange          Only run permutations first to last (e.g. 1 2500), to split the test over several nodes \n");
+		printf(" -mergecheckpoint           Add the permutations of a checkpoint from another permutation range (can be used several times) \n");
+		printf(" -batchcontrasts            Calculate all t-contrasts in each permutation at the same time, using the same permutations for all contrasts \n");
+		printf(" -fwecontrasts              Also correct for the number of contrasts, by using the max over contrasts (requires -batchcontrasts) \n");
+		printf(" -eb                        Text file with the exchangeability block of each subject, subjects are only permuted within their block \n");
+		printf(" -wholeblock                Permute (or sign flip) the exchangeability blocks as a whole instead (requires blocks of the same size) \n");
+		printf(" -vg                        Text file with the variance group of each subject, uses one variance per group (Welch / G-statistic, t-test only) \n");
         printf(" -quiet                     Don't print anything to the terminal (default false) \n");
         printf(" -verbose                   Print extra stuff (default false) \n");
         printf("\n\n");
@@ -464,6 +531,127 @@ int main(int argc, char **argv)
             PERMUTATION_INPUT_FILE = argv[i+1];
             i += 2;
         }
+        else if (strcmp(input,"-checkpoint") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -checkpoint !\n");
+                return EXIT_FAILURE;
+			}
+
+			USE_CHECKPOINT = true;
+            CHECKPOINT_FILE = argv[i+1];
+            i += 2;
+        }
+        else if (strcmp(input,"-checkpointinterval") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after -checkpointinterval !\n");
+                return EXIT_FAILURE;
+			}
+
+            long int temp = strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("Checkpoint interval must be an integer! You provided %s \n",argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            else if (temp <= 0)
+            {
+                printf("Checkpoint interval must be > 0!\n");
+                return EXIT_FAILURE;
+            }
+			CHECKPOINT_INTERVAL = (size_t)temp;
+            i += 2;
+        }
+        else if (strcmp(input,"-resume") == 0)
+        {
+			RESUME_PERMUTATIONS = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-permutationrange") == 0)
+        {
+			if ( (i+2) >= argc  )
+			{
+			    printf("Unable to read two values after -permutationrange !\n");
+                return EXIT_FAILURE;
+			}
+
+            long int first = strtol(argv[i+1], &p, 10);
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("First permutation must be an integer! You provided %s \n",argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            long int last = strtol(argv[i+2], &p, 10);
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("Last permutation must be an integer! You provided %s \n",argv[i+2]);
+				return EXIT_FAILURE;
+		    }
+            else if ( (first <= 0) || (last < first) )
+            {
+                printf("Permutation range must satisfy 0 < first <= last!\n");
+                return EXIT_FAILURE;
+            }
+
+			USE_PERMUTATION_RANGE = true;
+			FIRST_PERMUTATION = (size_t)first;
+			LAST_PERMUTATION = (size_t)last;
+            i += 3;
+        }
+        else if (strcmp(input,"-mergecheckpoint") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -mergecheckpoint !\n");
+                return EXIT_FAILURE;
+			}
+
+			MERGE_CHECKPOINT_FILES.push_back(argv[i+1]);
+            i += 2;
+        }
+        else if (strcmp(input,"-batchcontrasts") == 0)
+        {
+			BATCH_CONTRASTS = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-fwecontrasts") == 0)
+        {
+			FWE_CONTRASTS = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-eb") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -eb !\n");
+                return EXIT_FAILURE;
+			}
+
+			USE_EXCHANGEABILITY_BLOCKS = true;
+            EXCHANGEABILITY_BLOCKS_FILE = argv[i+1];
+            i += 2;
+        }
+        else if (strcmp(input,"-wholeblock") == 0)
+        {
+			WHOLE_BLOCK_PERMUTATION = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-vg") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -vg !\n");
+                return EXIT_FAILURE;
+			}
+
+			USE_VARIANCE_GROUPS = true;
+            VARIANCE_GROUPS_FILE = argv[i+1];
+            i += 2;
+        }
         else
         {
             printf("Unrecognized option! %s \n",argv[i]);
@@ -471,6 +659,12 @@ int main(int argc, char **argv)
         }                
     }
 
+	if (RESUME_PERMUTATIONS && !USE_CHECKPOINT)
+	{
+    	printf("-resume requires a checkpoint file, set with -checkpoint, aborting! \n");
+        return EXIT_FAILURE;
+	}
+
 	if (!FOUND_DESIGN)
 	{
     	printf("No design file detected, aborting! \n");
@@ -489,6 +683,30 @@ int main(int argc, char **argv)
         return EXIT_FAILURE;
 	}
 
+	if (BATCH_CONTRASTS && (ANALYZE_GROUP_MEAN || (STATISTICAL_TEST != 0)))
+	{
+    	printf("-batchcontrasts can only be used for t-tests, aborting! \n");
+        return EXIT_FAILURE;
+	}
+
+	if (FWE_CONTRASTS && !BATCH_CONTRASTS)
+	{
+    	printf("-fwecontrasts requires -batchcontrasts, aborting! \n");
+        return EXIT_FAILURE;
+	}
+
+	if (WHOLE_BLOCK_PERMUTATION && !USE_EXCHANGEABILITY_BLOCKS)
+	{
+    	printf("-wholeblock requires exchangeability blocks, set with -eb, aborting! \n");
+        return EXIT_FAILURE;
+	}
+
+	if (USE_VARIANCE_GROUPS && (ANALYZE_GROUP_MEAN || (STATISTICAL_TEST != 0)))
+	{
+    	printf("-vg can only be used for t-tests, aborting! \n");
+        return EXIT_FAILURE;
+	}
+
 	// Check if BROCCOLI_DIR variable is set
 	if (getenv("BROCCOLI_DIR") == NULL)
 	{
@@ -663,7 +881,7 @@ int main(int argc, char **argv)
 		}
 	
 		// Check for consistency
-		if ( tempNumber != NUMBER_OF_SUBJECTS )
+		if ( tempNumber != (int)NUMBER_OF_SUBJECTS )
 		{
 			design.close();
 			printf("Input data contains %zu volumes, while the design file says %i subjects. Aborting! \n",NUMBER_OF_SUBJECTS,tempNumber);
@@ -697,7 +915,7 @@ int main(int argc, char **argv)
 		contrasts >> tempNumber;
 	
 		// Check for consistency
-		if ( tempNumber != NUMBER_OF_GLM_REGRESSORS )
+		if ( tempNumber != (int)NUMBER_OF_GLM_REGRESSORS )
 		{
 			contrasts.close();
 			printf("Design file says that number of regressors is %zu, while contrast file says there are %i regressors. Aborting! \n",NUMBER_OF_GLM_REGRESSORS,tempNumber);
@@ -896,7 +1114,7 @@ int main(int argc, char **argv)
 		// Check if contrast matrix has full rank
 		Eigen::FullPivLU<Eigen::MatrixXd> luA(Contrasts);
 		int rank = luA.rank();
-		if (rank < NUMBER_OF_CONTRASTS)
+		if (rank < (int)NUMBER_OF_CONTRASTS)
 		{
 	        printf("Contrast matrix does not have full rank, at least one contrast can be written as a linear combination of other contrasts, not OK for F-test, aborting!\n");      
 	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
@@ -1083,7 +1301,7 @@ int main(int argc, char **argv)
 
 	if (!ANALYZE_GROUP_MEAN)
 	{
-		for (size_t c = 0; c < NUMBER_OF_STATISTICAL_MAPS; c++)
+		for (size_t c = 0; c < (size_t)NUMBER_OF_STATISTICAL_MAPS; c++)
 		{
 			NUMBER_OF_PERMUTATIONS_PER_CONTRAST[c] = NUMBER_OF_PERMUTATIONS;
 
@@ -1133,6 +1351,136 @@ int main(int argc, char **argv)
 		}
 	}
 
+	// Read exchangeability blocks, they limit the number of possible permutations (or sign flips)
+	if (USE_EXCHANGEABILITY_BLOCKS)
+	{
+		if (!ReadSubjectLabels(EXCHANGEABILITY_BLOCKS_FILE, EXCHANGEABILITY_BLOCKS, NUMBER_OF_EXCHANGEABILITY_BLOCKS, NUMBER_OF_SUBJECTS))
+		{
+	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+	        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+	        return EXIT_FAILURE;
+		}
+
+		std::vector<int> blockSizes(NUMBER_OF_EXCHANGEABILITY_BLOCKS, 0);
+		for (size_t s = 0; s < NUMBER_OF_SUBJECTS; s++)
+		{
+			blockSizes[EXCHANGEABILITY_BLOCKS[s]]++;
+		}
+
+		if (WHOLE_BLOCK_PERMUTATION && (std::count(blockSizes.begin(), blockSizes.end(), blockSizes[0]) != NUMBER_OF_EXCHANGEABILITY_BLOCKS))
+		{
+	        printf("All exchangeability blocks must contain the same number of subjects for whole block permutation, aborting!\n");
+	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+	        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+	        return EXIT_FAILURE;
+		}
+
+		double MAX_PERMS;
+		if (ANALYZE_GROUP_MEAN && WHOLE_BLOCK_PERMUTATION)
+		{
+			MAX_PERMS = pow(2.0, (double)NUMBER_OF_EXCHANGEABILITY_BLOCKS);
+		}
+		else if (ANALYZE_GROUP_MEAN)
+		{
+			MAX_PERMS = pow(2.0, (double)NUMBER_OF_SUBJECTS);
+		}
+		else if (WHOLE_BLOCK_PERMUTATION)
+		{
+			MAX_PERMS = round(exp(lgamma(NUMBER_OF_EXCHANGEABILITY_BLOCKS+1)));
+		}
+		else
+		{
+			double logPerms = 0.0;
+			for (int b = 0; b < NUMBER_OF_EXCHANGEABILITY_BLOCKS; b++)
+			{
+				logPerms += lgamma(blockSizes[b]+1);
+			}
+			MAX_PERMS = round(exp(logPerms));
+		}
+
+		printf("%i exchangeability blocks, max number of permutations is %g \n",NUMBER_OF_EXCHANGEABILITY_BLOCKS,MAX_PERMS);
+
+		for (size_t c = 0; c < (size_t)NUMBER_OF_STATISTICAL_MAPS; c++)
+		{
+			// For a two sample t-test only the different group labelings count (the first subjects belong to group 1, as in BROCCOLI)
+			double CONTRAST_MAX_PERMS = MAX_PERMS;
+			if (!ANALYZE_GROUP_MEAN && TWOSAMPLE_DESIGN[c])
+			{
+				std::vector< std::vector<int> > blockLabels(NUMBER_OF_EXCHANGEABILITY_BLOCKS);
+				for (size_t s = 0; s < NUMBER_OF_SUBJECTS; s++)
+				{
+					blockLabels[EXCHANGEABILITY_BLOCKS[s]].push_back(((int)s < NUMBER_OF_SUBJECTS_IN_GROUP1[c]) ? 1 : -1);
+				}
+
+				double logPerms = 0.0;
+				if (WHOLE_BLOCK_PERMUTATION)
+				{
+					// Blocks with the same labels give the same labeling when they are swapped
+					logPerms = lgamma(NUMBER_OF_EXCHANGEABILITY_BLOCKS+1);
+					std::vector<bool> counted(NUMBER_OF_EXCHANGEABILITY_BLOCKS, false);
+					for (int b = 0; b < NUMBER_OF_EXCHANGEABILITY_BLOCKS; b++)
+					{
+						if (counted[b])
+						{
+							continue;
+						}
+
+						int identicalBlocks = 0;
+						for (int b2 = b; b2 < NUMBER_OF_EXCHANGEABILITY_BLOCKS; b2++)
+						{
+							if (blockLabels[b2] == blockLabels[b])
+							{
+								counted[b2] = true;
+								identicalBlocks++;
+							}
+						}
+						logPerms -= lgamma(identicalBlocks+1);
+					}
+				}
+				else
+				{
+					for (int b = 0; b < NUMBER_OF_EXCHANGEABILITY_BLOCKS; b++)
+					{
+						int group1 = (int)std::count(blockLabels[b].begin(), blockLabels[b].end(), 1);
+						logPerms += lgamma(blockSizes[b]+1) - lgamma(group1+1) - lgamma(blockSizes[b]-group1+1);
+					}
+				}
+				CONTRAST_MAX_PERMS = round(exp(logPerms));
+			}
+
+			if ((double)NUMBER_OF_PERMUTATIONS_PER_CONTRAST[c] > CONTRAST_MAX_PERMS)
+			{
+				printf("Warning: Number of possible permutations with the exchangeability blocks is %g for contrast %zu, lowering number of permutations to number of possible permutations. \n",CONTRAST_MAX_PERMS,c+1);
+				NUMBER_OF_PERMUTATIONS_PER_CONTRAST[c] = (size_t)CONTRAST_MAX_PERMS;
+				DO_ALL_PERMUTATIONS = true;
+			}
+		}
+	}
+
+	// Read variance groups, each group needs residual degrees of freedom
+	if (USE_VARIANCE_GROUPS)
+	{
+		if (!ReadSubjectLabels(VARIANCE_GROUPS_FILE, VARIANCE_GROUPS, NUMBER_OF_VARIANCE_GROUPS, NUMBER_OF_SUBJECTS))
+		{
+	        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+	        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+	        return EXIT_FAILURE;
+		}
+
+		for (int g = 0; g < NUMBER_OF_VARIANCE_GROUPS; g++)
+		{
+			if (std::count(VARIANCE_GROUPS.begin(), VARIANCE_GROUPS.end(), g) < 2)
+			{
+		        printf("Each variance group must contain at least 2 subjects, aborting!\n");
+		        FreeAllMemory(allMemoryPointers,numberOfMemoryPointers);
+		        FreeAllNiftiImages(allNiftiImages,numberOfNiftiImages);
+		        return EXIT_FAILURE;
+			}
+		}
+
+		printf("%i variance groups \n",NUMBER_OF_VARIANCE_GROUPS);
+	}
+
 
 	// Calculate pseudo inverse
 	Eigen::MatrixXd xtx(NUMBER_OF_GLM_REGRESSORS,NUMBER_OF_GLM_REGRESSORS);
@@ -1216,7 +1564,7 @@ int main(int argc, char **argv)
 
 	AllocateMemory(h_Sign_Matrix, SIGN_MATRIX_SIZE, allMemoryPointers, numberOfMemoryPointers, allNiftiImages, numberOfNiftiImages, allocatedHostMemory, "SIGN_MATRIX");
 
-	for (size_t c = 0; c < NUMBER_OF_STATISTICAL_MAPS; c++)
+	for (size_t c = 0; c < (size_t)NUMBER_OF_STATISTICAL_MAPS; c++)
 	{ 
 	    size_t NULL_DISTRIBUTION_SIZE = NUMBER_OF_PERMUTATIONS_PER_CONTRAST[c] * sizeof(float);
 		size_t PERMUTATION_MATRIX_SIZE = NUMBER_OF_PERMUTATIONS_PER_CONTRAST[c] * NUMBER_OF_SUBJECTS * sizeof(unsigned short int);
@@ -1521,7 +1869,33 @@ int main(int argc, char **argv)
 		BROCCOLI.SetPermutationFileUsage(USE_PERMUTATION_FILE);
 		BROCCOLI.SetPrint(PRINT);
 
+		if (USE_CHECKPOINT)
+		{
+			BROCCOLI.SetPermutationCheckpointFile(CHECKPOINT_FILE);
+			BROCCOLI.SetPermutationCheckpointInterval(CHECKPOINT_INTERVAL);
+			BROCCOLI.SetResumePermutations(RESUME_PERMUTATIONS);
+		}
+		for (size_t m = 0; m < MERGE_CHECKPOINT_FILES.size(); m++)
+		{
+			BROCCOLI.AddPermutationCheckpointToMerge(MERGE_CHECKPOINT_FILES[m]);
+		}
+		if (USE_PERMUTATION_RANGE)
+		{
+			BROCCOLI.SetPermutationRange(FIRST_PERMUTATION - 1, LAST_PERMUTATION - 1);
+		}
+
 		BROCCOLI.SetGroupDesigns(GROUP_DESIGNS);
+		BROCCOLI.SetBatchContrastPermutations(BATCH_CONTRASTS);
+		BROCCOLI.SetCorrectAcrossContrasts(FWE_CONTRASTS);
+		if (USE_EXCHANGEABILITY_BLOCKS)
+		{
+			BROCCOLI.SetExchangeabilityBlocks(&EXCHANGEABILITY_BLOCKS[0], NUMBER_OF_EXCHANGEABILITY_BLOCKS);
+			BROCCOLI.SetWholeBlockPermutation(WHOLE_BLOCK_PERMUTATION);
+		}
+		if (USE_VARIANCE_GROUPS)
+		{
+			BROCCOLI.SetVarianceGroups(&VARIANCE_GROUPS[0], NUMBER_OF_VARIANCE_GROUPS);
+		}
 
         // Run the permutation test
 
@@ -1547,6 +1921,8 @@ int main(int argc, char **argv)
 
 		endTime = GetWallTime();
 
+		PERMUTATIONS_COMPLETE = BROCCOLI.GetPermutationDistributionsComplete();
+
 		if (VERBOS)
 	 	{
 			printf("\nIt took %f seconds to run the permutation test\n",(float)(endTime - startTime));
@@ -1695,7 +2071,11 @@ int main(int argc, char **argv)
 	{
 	    WriteNifti(outputNifti,h_Statistical_Maps,"_perm_fvalues",ADD_FILENAME,DONT_CHECK_EXISTING_FILE);
 	}
-    WriteNifti(outputNifti,h_P_Values,"_perm_pvalues",ADD_FILENAME,DONT_CHECK_EXISTING_FILE);
+	// No p-values for a partial permutation range
+	if (PERMUTATIONS_COMPLETE)
+	{
+	    WriteNifti(outputNifti,h_P_Values,"_perm_pvalues",ADD_FILENAME,DONT_CHECK_EXISTING_FILE);
+	}
 
 	endTime = GetWallTime();
 
@@ -109,6 +109,7 @@ int main(int argc, char **argv)
 	bool			WRITE_INTERPOLATED = false;
    	bool			CHANGE_OUTPUT_FILENAME = false;    
 	float			SIGMA = 5.0f;
+	int				INTERPOLATION_MODE = LINEAR;
 	bool			MASK = false;
 	bool			MASK_ORIGINAL = false;
 	const char* 	MASK_NAME;
@@ -142,6 +143,7 @@ int main(int argc, char **argv)
 
         printf(" -sigma                     Amount of Gaussian smoothing applied for regularization of the displacement field, defined as sigma of the Gaussian kernel (default 5.0)  \n");        
         printf(" -zcut                      Number of mm to cut from the bottom of the input volume, can be negative, useful if the head in the volume is placed very high or low (default 0) \n");        
+        printf(" -interpolation             The interpolation to use for the aligned volumes, 1 = trilinear, 3 = cubic B-spline, 4 = Lanczos (default 1). The registration itself always uses trilinear interpolation \n");
         printf(" -precenter                 Center the input volume before the registration starts (default off) \n");        
         printf(" -mask                      Mask to apply after linear and non-linear registration, to for example do a skullstrip (default none) \n");        
         printf(" -maskoriginal              Mask to apply after linear registration, to for example do a skullstrip. Returns the volume skullstripped and unregistered (but interpolated to the reference volume size) (default none) \n");        
@@ -360,6 +362,28 @@ int main(int argc, char **argv)
 		    }
 
             i += 2;
+        }
+		else if (strcmp(input,"-interpolation") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after -interpolation !\n");
+                return EXIT_FAILURE;
+			}
+
+            INTERPOLATION_MODE = (int)strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("Interpolation mode must be an integer! You provided %s \n",argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+			if ( (INTERPOLATION_MODE != LINEAR) && (INTERPOLATION_MODE != BSPLINE) && (INTERPOLATION_MODE != LANCZOS) )
+            {
+			    printf("Interpolation mode has to be 1, 3 or 4!\n");
+                return EXIT_FAILURE;
+			}
+			i += 2;
         }
 		else if (strcmp(input,"-precenter") == 0)
         {
@@ -1104,7 +1128,7 @@ int main(int argc, char **argv)
         BROCCOLI.SetMNIVoxelSizeY(MNI_VOXEL_SIZE_Y);
         BROCCOLI.SetMNIVoxelSizeZ(MNI_VOXEL_SIZE_Z);                
         
-        BROCCOLI.SetInterpolationMode(LINEAR);
+        BROCCOLI.SetInterpolationMode(INTERPOLATION_MODE);
         BROCCOLI.SetNumberOfIterationsForLinearImageRegistration(NUMBER_OF_ITERATIONS_FOR_LINEAR_IMAGE_REGISTRATION);
         BROCCOLI.SetNumberOfIterationsForNonLinearImageRegistration(NUMBER_OF_ITERATIONS_FOR_NONLINEAR_IMAGE_REGISTRATION);
         BROCCOLI.SetImageRegistrationFilterSize(IMAGE_REGISTRATION_FILTER_SIZE);    
@@ -85,6 +85,7 @@ int main(int argc, char ** argv)
 	bool			MASK = false;
 	bool			AUTO_MASK = false;
 	const char*		MASK_NAME;
+	int				SMOOTHING_METHOD = SMOOTHING_METHOD_AUTOMATIC;
 
     //-----------------------
     // Output parameters
@@ -107,6 +108,8 @@ int main(int argc, char ** argv)
         printf(" -fwhm            Amount of smoothing to apply (in mm, default 6 mm) \n");
         printf(" -mask            Perform smoothing inside mask (normalized convolution) \n");
         printf(" -automask        Generate a mask and perform smoothing inside mask (normalized convolution) \n");
+        printf(" -fir             Always use the 9 tap filters, the Gaussian is truncated for large FWHM (default automatic) \n");
+        printf(" -recursive       Always use the recursive Gaussian, the speed does not depend on the FWHM (default automatic) \n");
         printf(" -output          Set output filename (default input_sm.nii) \n");
         printf(" -quiet           Don't print anything to the terminal (default false) \n");
         printf(" -verbose         Print extra stuff (default false) \n");
@@ -226,6 +229,16 @@ int main(int argc, char ** argv)
             AUTO_MASK = true;
             i += 1;
         }
+        else if (strcmp(input,"-fir") == 0)
+        {
+            SMOOTHING_METHOD = SMOOTHING_METHOD_FIR;
+            i += 1;
+        }
+        else if (strcmp(input,"-recursive") == 0)
+        {
+            SMOOTHING_METHOD = SMOOTHING_METHOD_RECURSIVE;
+            i += 1;
+        }
         else if (strcmp(input,"-debug") == 0)
         {
             DEBUG = true;
@@ -597,6 +610,7 @@ int main(int argc, char ** argv)
 		BROCCOLI.SetInputCertainty(h_Certainty);
 
         BROCCOLI.SetEPISmoothingAmount(EPI_SMOOTHING_AMOUNT);
+        BROCCOLI.SetSmoothingMethod(SMOOTHING_METHOD);
 		BROCCOLI.SetAllocatedHostMemory(allocatedHostMemory);
 
         BROCCOLI.SetEPIWidth(DATA_W);
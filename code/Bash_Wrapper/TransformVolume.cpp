@@ -121,7 +121,7 @@ int main(int argc, char **argv)
         printf(" -scaling                   A scaling to apply to each dimension \n");
         printf(" -centering                 Center the volume mass \n");
         printf(" -field                     An arbitrary deformation field in three files \n");
-		printf(" -interpolation             The interpolation to use, 0 = nearest neighbour, 1 = trilinear (default 1) \n");
+		printf(" -interpolation             The interpolation to use, 0 = nearest neighbour, 1 = trilinear, 3 = cubic B-spline, 4 = Lanczos (default 1) \n");
 		printf(" -zcut                      Number of mm to cut from the bottom of the input volume, can be negative (default 0). Should be the same as for the call to RegisterTwoVolumes\n"); 
 		printf(" -output                    Set output filename (default volume_to_transform_warped.nii) \n");
         printf(" -quiet                     Don't print anything to the terminal (default false) \n");
@@ -308,9 +308,9 @@ int main(int argc, char **argv)
 		        printf("Interpolation mode must be an integer! You provided %s \n",argv[i+1]);
 				return EXIT_FAILURE;
 		    }
-			if ( (INTERPOLATION_MODE != 0) && (INTERPOLATION_MODE != 1) )
+			if ( (INTERPOLATION_MODE != 0) && (INTERPOLATION_MODE != 1) && (INTERPOLATION_MODE != 3) && (INTERPOLATION_MODE != 4) )
             {
-			    printf("Interpolation mode has to be 0 or 1!\n");
+			    printf("Interpolation mode has to be 0, 1, 3 or 4!\n");
                 return EXIT_FAILURE;          	
 			}
 			i += 2;
@@ -0,0 +1,967 @@
+/*
+ * BROCCOLI: Software for Fast fMRI Analysis on Many-Core CPUs and GPUs
+ * Copyright (C) <2013>  Anders Eklund, andek034@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Runs synthetic datasets, generated from a fixed seed, through T1-to-MNI registration,
+// motion correction, smoothing, first level GLM and permutation inference, and reports
+// the throughput of each stage. Any OpenCL device can be used, including CPU runtimes.
+
+#include "broccoli_lib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+
+#define STAGE_REGISTRATION 0
+#define STAGE_MOTION_CORRECTION 1
+#define STAGE_SMOOTHING 2
+#define STAGE_FIRST_LEVEL_GLM 3
+#define STAGE_PERMUTATION 4
+#define STAGE_BAYESIAN 5
+#define STAGE_VARIATIONAL_BAYES 6
+#define NUMBER_OF_STAGES 7
+
+const char* stageNames[NUMBER_OF_STAGES] = {"registration", "motioncorrection", "smoothing", "glm", "permutation", "bayesian", "vb"};
+
+struct Blob
+{
+	float x, y, z;
+	float sigma;
+	float amplitude;
+};
+
+struct StageResult
+{
+	bool run;
+	std::vector<double> wallTimes;
+	double deviceTime;
+	double transferredMB;
+	double work;
+	const char* unit;
+};
+
+double GetWallTime()
+{
+    struct timeval time;
+    if (gettimeofday(&time,NULL))
+    {
+        //  Handle error
+        return 0;
+    }
+    return (double)time.tv_sec + (double)time.tv_usec * .000001;
+}
+
+// Simple LCG, to get the same data on all platforms
+float RandomUniform(unsigned int& state)
+{
+	state = 1664525u * state + 1013904223u;
+	return (float)(state >> 8) / 16777216.0f;
+}
+
+float RandomNormal(unsigned int& state)
+{
+	float u1 = RandomUniform(state) + 1e-7f;
+	float u2 = RandomUniform(state);
+	return sqrt(-2.0f * log(u1)) * cos(2.0f * 3.14159265f * u2);
+}
+
+void GenerateBlobs(std::vector<Blob>& blobs, int N, int DATA_W, int DATA_H, int DATA_D, unsigned int& state)
+{
+	blobs.clear();
+	for (int b = 0; b < N; b++)
+	{
+		Blob blob;
+		blob.x = (0.2f + 0.6f * RandomUniform(state)) * (float)DATA_W;
+		blob.y = (0.2f + 0.6f * RandomUniform(state)) * (float)DATA_H;
+		blob.z = (0.2f + 0.6f * RandomUniform(state)) * (float)DATA_D;
+		blob.sigma = 2.0f + 4.0f * RandomUniform(state);
+		blob.amplitude = 100.0f + 400.0f * RandomUniform(state);
+		blobs.push_back(blob);
+	}
+}
+
+// Sum of Gaussian blobs on top of a brain shaped ellipsoid, sampled at a shifted position
+void GenerateVolume(float* volume, std::vector<Blob>& blobs, int DATA_W, int DATA_H, int DATA_D, float shiftX, float shiftY, float shiftZ)
+{
+	#pragma omp parallel for
+	for (int z = 0; z < DATA_D; z++)
+	{
+		for (int y = 0; y < DATA_H; y++)
+		{
+			for (int x = 0; x < DATA_W; x++)
+			{
+				float xx = (float)x - shiftX;
+				float yy = (float)y - shiftY;
+				float zz = (float)z - shiftZ;
+
+				float ex = (xx - 0.5f * DATA_W) / (0.4f * DATA_W);
+				float ey = (yy - 0.5f * DATA_H) / (0.45f * DATA_H);
+				float ez = (zz - 0.5f * DATA_D) / (0.45f * DATA_D);
+				float value = 0.0f;
+				if ( (ex*ex + ey*ey + ez*ez) <= 1.0f )
+				{
+					value = 1000.0f;
+				}
+
+				for (size_t b = 0; b < blobs.size(); b++)
+				{
+					float dx = xx - blobs[b].x;
+					float dy = yy - blobs[b].y;
+					float dz = zz - blobs[b].z;
+					value += blobs[b].amplitude * exp(-(dx*dx + dy*dy + dz*dz) / (2.0f * blobs[b].sigma * blobs[b].sigma));
+				}
+				volume[x + y * DATA_W + z * DATA_W * DATA_H] = value;
+			}
+		}
+	}
+}
+
+// Volumes with small random rigid translations, used for motion correction and smoothing
+void GenerateMovingVolumes(float* volumes, std::vector<Blob>& blobs, int DATA_W, int DATA_H, int DATA_D, int DATA_T, unsigned int seed)
+{
+	unsigned int state = seed;
+	for (int t = 0; t < DATA_T; t++)
+	{
+		float shiftX = 0.5f * RandomNormal(state);
+		float shiftY = 0.5f * RandomNormal(state);
+		float shiftZ = 0.5f * RandomNormal(state);
+		GenerateVolume(&volumes[(size_t)t * DATA_W * DATA_H * DATA_D], blobs, DATA_W, DATA_H, DATA_D, shiftX, shiftY, shiftZ);
+	}
+}
+
+// Block design with activity in the blobs, plus white noise
+void GenerateActivityVolumes(float* volumes, float* X, std::vector<Blob>& blobs, int DATA_W, int DATA_H, int DATA_D, int DATA_T, unsigned int seed)
+{
+	size_t VOLUME = (size_t)DATA_W * DATA_H * DATA_D;
+
+	// Two boxcar regressors with different periods
+	for (int t = 0; t < DATA_T; t++)
+	{
+		X[t + 0 * DATA_T] = ((t / 10) % 2 == 1) ? 1.0f : 0.0f;
+		X[t + 1 * DATA_T] = ((t / 15) % 2 == 1) ? 1.0f : 0.0f;
+	}
+
+	float* baseline = (float*)malloc(VOLUME * sizeof(float));
+	GenerateVolume(baseline, blobs, DATA_W, DATA_H, DATA_D, 0.0f, 0.0f, 0.0f);
+
+	for (int t = 0; t < DATA_T; t++)
+	{
+		unsigned int state = seed + 7919u * (unsigned int)t;
+		float* volume = &volumes[(size_t)t * VOLUME];
+		for (size_t i = 0; i < VOLUME; i++)
+		{
+			float activity = (baseline[i] > 1000.0f) ? 0.02f * (baseline[i] - 1000.0f) : 0.0f;
+			volume[i] = baseline[i] + activity * X[t] + 10.0f * RandomNormal(state);
+		}
+	}
+
+	free(baseline);
+}
+
+// First level results for a group, activity in the blobs for all subjects
+void GenerateGroupVolumes(float* volumes, float* mask, std::vector<Blob>& blobs, int DATA_W, int DATA_H, int DATA_D, int NUMBER_OF_SUBJECTS, unsigned int seed)
+{
+	size_t VOLUME = (size_t)DATA_W * DATA_H * DATA_D;
+
+	GenerateVolume(mask, blobs, DATA_W, DATA_H, DATA_D, 0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < VOLUME; i++)
+	{
+		mask[i] = (mask[i] >= 1000.0f) ? 1.0f : 0.0f;
+	}
+
+	float* effect = (float*)malloc(VOLUME * sizeof(float));
+	std::vector<Blob> effectBlobs = blobs;
+	for (size_t b = 0; b < effectBlobs.size(); b++)
+	{
+		effectBlobs[b].amplitude = 1.0f;
+	}
+	GenerateVolume(effect, effectBlobs, DATA_W, DATA_H, DATA_D, 0.0f, 0.0f, 0.0f);
+
+	for (int s = 0; s < NUMBER_OF_SUBJECTS; s++)
+	{
+		unsigned int state = seed + 104729u * (unsigned int)s;
+		float* volume = &volumes[(size_t)s * VOLUME];
+		for (size_t i = 0; i < VOLUME; i++)
+		{
+			float e = (mask[i] == 1.0f) ? (effect[i] - 1000.0f) : 0.0f;
+			volume[i] = mask[i] * (e + RandomNormal(state));
+		}
+	}
+
+	free(effect);
+}
+
+bool ReadFilter(float* filter, int size, std::string filename)
+{
+	FILE *fp = fopen(filename.c_str(),"rb");
+	if (fp == NULL)
+	{
+		printf("Could not open %s , aborting! \n",filename.c_str());
+		return false;
+	}
+	size_t read = fread(filter,sizeof(float),size,fp);
+	fclose(fp);
+	return (read == (size_t)size);
+}
+
+// Reads the real and imaginary parts of the quadrature filters, registration is "linear" or "nonlinear"
+bool ReadQuadratureFilters(std::vector<float>& filters, int NUMBER_OF_FILTERS, int FILTER_SIZE, const char* registration)
+{
+	int F = FILTER_SIZE * FILTER_SIZE * FILTER_SIZE;
+	filters.resize(2 * NUMBER_OF_FILTERS * F);
+	for (int f = 0; f < 2 * NUMBER_OF_FILTERS; f++)
+	{
+		std::ostringstream filename;
+		filename << getenv("BROCCOLI_DIR") << "filters/filter" << (f / 2 + 1) << ((f % 2 == 0) ? "_real_" : "_imag_") << registration << "_registration.bin";
+		if (!ReadFilter(&filters[f * F], F, filename.str()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Projection tensors (6 values each) and filter directions for the non-linear registration
+bool ReadNonLinearRegistrationParameters(std::vector<float>& tensors, std::vector<float>& directions)
+{
+	const char* directionNames[3] = {"x", "y", "z"};
+
+	tensors.resize(6 * NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION);
+	directions.resize(3 * NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION);
+	for (int t = 0; t < 6; t++)
+	{
+		std::ostringstream filename;
+		filename << getenv("BROCCOLI_DIR") << "filters/projection_tensor" << (t + 1) << ".bin";
+		if (!ReadFilter(&tensors[t * NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION], NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION, filename.str()))
+		{
+			return false;
+		}
+	}
+	for (int d = 0; d < 3; d++)
+	{
+		std::ostringstream filename;
+		filename << getenv("BROCCOLI_DIR") << "filters/filter_directions_" << directionNames[d] << ".bin";
+		if (!ReadFilter(&directions[d * NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION], NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION, filename.str()))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CheckInitialization(BROCCOLI_LIB& BROCCOLI)
+{
+	if (!BROCCOLI.GetOpenCLInitiated())
+	{
+		printf("Initialization error is \"%s\" \n",BROCCOLI.GetOpenCLInitializationError().c_str());
+		printf("OpenCL error is \"%s\" \n",BROCCOLI.GetOpenCLError());
+		printf("OpenCL initialization failed, aborting! \n");
+		return false;
+	}
+	return true;
+}
+
+void PrintRunKernelErrors(BROCCOLI_LIB& BROCCOLI, const char* stage)
+{
+	int* runKernelErrors = BROCCOLI.GetOpenCLRunKernelErrors();
+	for (int i = 0; i < BROCCOLI.GetNumberOfOpenCLKernels(); i++)
+	{
+		if (runKernelErrors[i] != 0)
+		{
+			printf("Run kernel error in stage %s for kernel '%s' is '%s' \n",stage,BROCCOLI.GetOpenCLKernelName(i),BROCCOLI.GetOpenCLErrorMessage(runKernelErrors[i]));
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+    // Default parameters
+    int             OPENCL_PLATFORM = 0;
+    int             OPENCL_DEVICE = 0;
+	bool			VERBOS = false;
+
+	unsigned int	SEED = 1234;
+	int				REPETITIONS = 3;
+
+	// EPI data
+	int				EPI_DATA_W = 64;
+	int				EPI_DATA_H = 64;
+	int				EPI_DATA_D = 33;
+	int				EPI_DATA_T = 200;
+	float			EPI_VOXEL_SIZE = 3.0f;
+
+	// MNI data, 2 mm
+	int				MNI_DATA_W = 91;
+	int				MNI_DATA_H = 109;
+	int				MNI_DATA_D = 91;
+	float			MNI_VOXEL_SIZE = 2.0f;
+
+	// T1 data, 1.5 mm, covering the same field of view as the MNI data
+	int				T1_DATA_W = 121;
+	int				T1_DATA_H = 145;
+	int				T1_DATA_D = 121;
+	float			T1_VOXEL_SIZE = 1.5f;
+	int				NUMBER_OF_ITERATIONS_FOR_LINEAR_IMAGE_REGISTRATION = 10;
+	int				NUMBER_OF_ITERATIONS_FOR_NONLINEAR_IMAGE_REGISTRATION = 10;
+
+	int				NUMBER_OF_SUBJECTS = 20;
+	size_t			NUMBER_OF_PERMUTATIONS = 1000;
+	int				NUMBER_OF_MCMC_ITERATIONS = 1000;
+
+	bool			RUN_STAGE[NUMBER_OF_STAGES];
+	for (int s = 0; s < NUMBER_OF_STAGES; s++)
+	{
+		RUN_STAGE[s] = true;
+	}
+
+	const char*		TRACE_PREFIX = NULL;
+	const char*		OUTPUT_FILE = NULL;
+	bool			AUTOTUNE = false;
+
+    // No inputs, so print help text
+    if (argc == 1)
+    {
+        printf("Usage:\n\n");
+        printf("Benchmark -platform x -device y [options]\n\n");
+        printf("Options:\n\n");
+        printf(" -platform           The OpenCL platform to use (default 0) \n");
+        printf(" -device             The OpenCL device to use for the specificed platform (default 0) \n");
+        printf(" -stage              Only run one stage: registration, motioncorrection, smoothing, glm, permutation, bayesian or vb (default all) \n");
+        printf(" -seed               Seed for the synthetic data (default 1234) \n");
+        printf(" -repetitions        Number of runs of each stage (default 3) \n");
+        printf(" -timepoints         Number of volumes in the synthetic fMRI data (default 200) \n");
+        printf(" -subjects           Number of subjects for the permutation test (default 20) \n");
+        printf(" -permutations       Number of permutations (default 1000) \n");
+        printf(" -iterationsmcmc     Number of MCMC iterations for the Bayesian GLM (default 1000) \n");
+        printf(" -trace              Save a Chrome trace (chrome://tracing) of each stage to prefix_stage.json \n");
+        printf(" -output             Append the results to a text file, to compare releases \n");
+        printf(" -autotune           Find the fastest work-group sizes for the device before benchmarking, and save them to the profile of the device \n");
+        printf(" -verbose            Print a summary of all kernels and transfers of each stage \n");
+        printf("\n\n");
+
+        return EXIT_SUCCESS;
+    }
+
+ 	// Loop over additional inputs
+    int i = 1;
+    while (i < argc)
+    {
+        char *input = argv[i];
+        char *p;
+        if ( (strcmp(input,"-platform") == 0) || (strcmp(input,"-device") == 0) || (strcmp(input,"-repetitions") == 0) || (strcmp(input,"-timepoints") == 0) || (strcmp(input,"-subjects") == 0) || (strcmp(input,"-permutations") == 0) || (strcmp(input,"-iterationsmcmc") == 0) || (strcmp(input,"-seed") == 0) )
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after %s !\n",input);
+                return EXIT_FAILURE;
+			}
+
+            long value = strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("%s must be an integer! You provided %s \n",input,argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            else if ( (value < 0) || ((value == 0) && (strcmp(input,"-platform") != 0) && (strcmp(input,"-device") != 0) && (strcmp(input,"-seed") != 0)) )
+            {
+                printf("Invalid value for %s ! You provided %s \n",input,argv[i+1]);
+                return EXIT_FAILURE;
+            }
+
+			if (strcmp(input,"-platform") == 0)
+				OPENCL_PLATFORM = (int)value;
+			else if (strcmp(input,"-device") == 0)
+				OPENCL_DEVICE = (int)value;
+			else if (strcmp(input,"-repetitions") == 0)
+				REPETITIONS = (int)value;
+			else if (strcmp(input,"-timepoints") == 0)
+				EPI_DATA_T = (int)value;
+			else if (strcmp(input,"-subjects") == 0)
+				NUMBER_OF_SUBJECTS = (int)value;
+			else if (strcmp(input,"-permutations") == 0)
+				NUMBER_OF_PERMUTATIONS = (size_t)value;
+			else if (strcmp(input,"-iterationsmcmc") == 0)
+				NUMBER_OF_MCMC_ITERATIONS = (int)value;
+			else if (strcmp(input,"-seed") == 0)
+				SEED = (unsigned int)value;
+            i += 2;
+        }
+        else if (strcmp(input,"-stage") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -stage !\n");
+                return EXIT_FAILURE;
+			}
+
+			int stage = -1;
+			for (int s = 0; s < NUMBER_OF_STAGES; s++)
+			{
+				RUN_STAGE[s] = (strcmp(argv[i+1],stageNames[s]) == 0);
+				if (RUN_STAGE[s])
+				{
+					stage = s;
+				}
+			}
+
+			if (stage < 0)
+			{
+                printf("Unknown stage %s ! Use registration, motioncorrection, smoothing, glm, permutation, bayesian or vb \n",argv[i+1]);
+                return EXIT_FAILURE;
+			}
+            i += 2;
+        }
+        else if (strcmp(input,"-trace") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -trace !\n");
+                return EXIT_FAILURE;
+			}
+			TRACE_PREFIX = argv[i+1];
+            i += 2;
+        }
+        else if (strcmp(input,"-output") == 0)
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read name after -output !\n");
+                return EXIT_FAILURE;
+			}
+			OUTPUT_FILE = argv[i+1];
+            i += 2;
+        }
+        else if (strcmp(input,"-autotune") == 0)
+        {
+			AUTOTUNE = true;
+            i += 1;
+        }
+        else if (strcmp(input,"-verbose") == 0)
+        {
+			VERBOS = true;
+            i += 1;
+        }
+        else
+        {
+            printf("Unrecognized option! %s \n",argv[i]);
+            return EXIT_FAILURE;
+        }
+	}
+
+	if ( (RUN_STAGE[STAGE_PERMUTATION]) && (NUMBER_OF_SUBJECTS < 12) && ((size_t)1 << NUMBER_OF_SUBJECTS) < NUMBER_OF_PERMUTATIONS )
+	{
+		printf("Too few subjects for %zu sign flips, aborting!\n",NUMBER_OF_PERMUTATIONS);
+		return EXIT_FAILURE;
+	}
+
+	// Check if BROCCOLI_DIR variable is set, needed for kernels and filters
+	if (getenv("BROCCOLI_DIR") == NULL)
+	{
+        printf("The environment variable BROCCOLI_DIR is not set!\n");
+        return EXIT_FAILURE;
+	}
+
+	StageResult results[NUMBER_OF_STAGES];
+	for (int s = 0; s < NUMBER_OF_STAGES; s++)
+	{
+		results[s].run = false;
+		results[s].deviceTime = 0.0;
+		results[s].transferredMB = 0.0;
+		results[s].work = 0.0;
+		results[s].unit = "";
+	}
+
+	std::string deviceName, platformName;
+
+	size_t EPI_VOLUME = (size_t)EPI_DATA_W * EPI_DATA_H * EPI_DATA_D;
+	size_t MNI_VOLUME = (size_t)MNI_DATA_W * MNI_DATA_H * MNI_DATA_D;
+	size_t T1_VOLUME = (size_t)T1_DATA_W * T1_DATA_H * T1_DATA_D;
+
+	unsigned int state = SEED;
+	std::vector<Blob> epiBlobs, mniBlobs;
+	GenerateBlobs(epiBlobs, 20, EPI_DATA_W, EPI_DATA_H, EPI_DATA_D, state);
+	GenerateBlobs(mniBlobs, 30, MNI_DATA_W, MNI_DATA_H, MNI_DATA_D, state);
+
+	// Tune on an EPI volume, the stages below then load the new profile
+	if (AUTOTUNE)
+	{
+		BROCCOLI_LIB BROCCOLI(OPENCL_PLATFORM,OPENCL_DEVICE,2,VERBOS); // 2 = Bash wrapper
+		if (!CheckInitialization(BROCCOLI))
+		{
+			return EXIT_FAILURE;
+		}
+		if (!BROCCOLI.AutotuneWorkGroupSizes(EPI_DATA_W, EPI_DATA_H, EPI_DATA_D))
+		{
+			printf("Autotuning failed, using default work-group sizes \n");
+		}
+		BROCCOLI.PrintWorkGroupSizes();
+		printf("\n");
+	}
+
+	for (int stage = 0; stage < NUMBER_OF_STAGES; stage++)
+	{
+		if (!RUN_STAGE[stage])
+		{
+			continue;
+		}
+
+		// New instance for each stage, so that no state is shared between stages
+		BROCCOLI_LIB BROCCOLI(OPENCL_PLATFORM,OPENCL_DEVICE,2,false); // 2 = Bash wrapper
+		if (!CheckInitialization(BROCCOLI))
+		{
+			return EXIT_FAILURE;
+		}
+		deviceName = BROCCOLI.GetOpenCLDeviceName();
+		platformName = BROCCOLI.GetOpenCLPlatformName();
+
+		BROCCOLI.SetPrint(false);
+		BROCCOLI.SetProfiling(true);
+
+		results[stage].run = true;
+
+		for (int r = 0; r < REPETITIONS; r++)
+		{
+			// Same seed for all repetitions, data is regenerated since some stages work in place
+			srand(SEED);
+
+			double startTime = 0.0, endTime = 0.0;
+
+			if (stage == STAGE_REGISTRATION)
+			{
+				int FILTER_SIZE = 7;
+				int F = FILTER_SIZE * FILTER_SIZE * FILTER_SIZE;
+				std::vector<float> linearFilters, nonLinearFilters, tensors, directions;
+				if ( !ReadQuadratureFilters(linearFilters, 3, FILTER_SIZE, "linear") || !ReadQuadratureFilters(nonLinearFilters, NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION, FILTER_SIZE, "nonlinear") || !ReadNonLinearRegistrationParameters(tensors, directions) )
+				{
+					return EXIT_FAILURE;
+				}
+				float* l = &linearFilters[0];
+				float* n = &nonLinearFilters[0];
+				float* t = &tensors[0];
+				int N = NUMBER_OF_FILTERS_FOR_NONLINEAR_REGISTRATION;
+
+				// The T1 volume has the same blobs as the MNI volume, at the T1 resolution and shifted a few voxels
+				float scale = MNI_VOXEL_SIZE / T1_VOXEL_SIZE;
+				std::vector<Blob> t1Blobs = mniBlobs;
+				for (size_t b = 0; b < t1Blobs.size(); b++)
+				{
+					t1Blobs[b].x *= scale;
+					t1Blobs[b].y *= scale;
+					t1Blobs[b].z *= scale;
+					t1Blobs[b].sigma *= scale;
+				}
+
+				std::vector<float> T1(T1_VOLUME);
+				std::vector<float> MNIBrain(MNI_VOLUME);
+				std::vector<float> MNIMask(MNI_VOLUME, 1.0f);
+				std::vector<float> interpolatedT1(MNI_VOLUME), alignedT1Linear(MNI_VOLUME), alignedT1NonLinear(MNI_VOLUME), skullstrippedT1(MNI_VOLUME);
+				std::vector<float> displacementX(MNI_VOLUME), displacementY(MNI_VOLUME), displacementZ(MNI_VOLUME);
+				std::vector<float> registrationParameters(12); // Affine
+				GenerateVolume(&T1[0], t1Blobs, T1_DATA_W, T1_DATA_H, T1_DATA_D, 4.0f, -3.0f, 2.0f);
+				GenerateVolume(&MNIBrain[0], mniBlobs, MNI_DATA_W, MNI_DATA_H, MNI_DATA_D, 0.0f, 0.0f, 0.0f);
+
+				BROCCOLI.SetInputT1Volume(&T1[0]);
+				BROCCOLI.SetInputMNIBrainVolume(&MNIBrain[0]);
+				BROCCOLI.SetInputMNIBrainMask(&MNIMask[0]);
+				BROCCOLI.SetT1Width(T1_DATA_W);
+				BROCCOLI.SetT1Height(T1_DATA_H);
+				BROCCOLI.SetT1Depth(T1_DATA_D);
+				BROCCOLI.SetT1Timepoints(1);
+				BROCCOLI.SetT1VoxelSizeX(T1_VOXEL_SIZE);
+				BROCCOLI.SetT1VoxelSizeY(T1_VOXEL_SIZE);
+				BROCCOLI.SetT1VoxelSizeZ(T1_VOXEL_SIZE);
+				BROCCOLI.SetMNIWidth(MNI_DATA_W);
+				BROCCOLI.SetMNIHeight(MNI_DATA_H);
+				BROCCOLI.SetMNIDepth(MNI_DATA_D);
+				BROCCOLI.SetMNIVoxelSizeX(MNI_VOXEL_SIZE);
+				BROCCOLI.SetMNIVoxelSizeY(MNI_VOXEL_SIZE);
+				BROCCOLI.SetMNIVoxelSizeZ(MNI_VOXEL_SIZE);
+				BROCCOLI.SetInterpolationMode(LINEAR);
+				BROCCOLI.SetNumberOfIterationsForLinearImageRegistration(NUMBER_OF_ITERATIONS_FOR_LINEAR_IMAGE_REGISTRATION);
+				BROCCOLI.SetNumberOfIterationsForNonLinearImageRegistration(NUMBER_OF_ITERATIONS_FOR_NONLINEAR_IMAGE_REGISTRATION);
+				BROCCOLI.SetImageRegistrationFilterSize(FILTER_SIZE);
+				BROCCOLI.SetLinearImageRegistrationFilters(l, l + F, l + 2*F, l + 3*F, l + 4*F, l + 5*F);
+				BROCCOLI.SetNonLinearImageRegistrationFilters(n, n + F, n + 2*F, n + 3*F, n + 4*F, n + 5*F, n + 6*F, n + 7*F, n + 8*F, n + 9*F, n + 10*F, n + 11*F);
+				BROCCOLI.SetProjectionTensorMatrixFirstFilter(t[0],t[1],t[2],t[3],t[4],t[5]);
+				BROCCOLI.SetProjectionTensorMatrixSecondFilter(t[N],t[N+1],t[N+2],t[N+3],t[N+4],t[N+5]);
+				BROCCOLI.SetProjectionTensorMatrixThirdFilter(t[2*N],t[2*N+1],t[2*N+2],t[2*N+3],t[2*N+4],t[2*N+5]);
+				BROCCOLI.SetProjectionTensorMatrixFourthFilter(t[3*N],t[3*N+1],t[3*N+2],t[3*N+3],t[3*N+4],t[3*N+5]);
+				BROCCOLI.SetProjectionTensorMatrixFifthFilter(t[4*N],t[4*N+1],t[4*N+2],t[4*N+3],t[4*N+4],t[4*N+5]);
+				BROCCOLI.SetProjectionTensorMatrixSixthFilter(t[5*N],t[5*N+1],t[5*N+2],t[5*N+3],t[5*N+4],t[5*N+5]);
+				BROCCOLI.SetFilterDirections(&directions[0], &directions[N], &directions[2*N]);
+				BROCCOLI.SetCoarsestScaleT1MNI(4); // Coarsest scale with at least 16 voxels in each dimension, as in RegisterTwoVolumes
+				BROCCOLI.SetMMT1ZCUT(0);
+				BROCCOLI.SetTsigma(5.0f);
+				BROCCOLI.SetEsigma(5.0f);
+				BROCCOLI.SetDsigma(5.0f);
+				BROCCOLI.SetOutputInterpolatedT1Volume(&interpolatedT1[0]);
+				BROCCOLI.SetOutputAlignedT1VolumeLinear(&alignedT1Linear[0]);
+				BROCCOLI.SetOutputAlignedT1VolumeNonLinear(&alignedT1NonLinear[0]);
+				BROCCOLI.SetOutputSkullstrippedT1Volume(&skullstrippedT1[0]);
+				BROCCOLI.SetOutputT1MNIRegistrationParameters(&registrationParameters[0]);
+				BROCCOLI.SetOutputDisplacementField(&displacementX[0], &displacementY[0], &displacementZ[0]);
+				BROCCOLI.SetPrecenterRegistration(false);
+				BROCCOLI.SetDoSkullstrip(false);
+				BROCCOLI.SetDoSkullstripOriginal(false);
+				BROCCOLI.SetSaveDisplacementField(false);
+				BROCCOLI.SetSaveInterpolatedT1(false);
+				BROCCOLI.SetSaveAlignedT1MNILinear(true);
+				BROCCOLI.SetSaveAlignedT1MNINonLinear(true);
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformRegistrationTwoVolumesWrapper();
+				endTime = GetWallTime();
+
+				results[stage].work = (double)MNI_VOLUME;
+				results[stage].unit = "Mvoxels/s";
+			}
+			else if (stage == STAGE_MOTION_CORRECTION)
+			{
+				int FILTER_SIZE = 7;
+				std::vector<float> filters;
+				if (!ReadQuadratureFilters(filters, 3, FILTER_SIZE, "linear"))
+				{
+					return EXIT_FAILURE;
+				}
+				float* f = &filters[0];
+				int F = FILTER_SIZE * FILTER_SIZE * FILTER_SIZE;
+
+				std::vector<float> volumes(EPI_VOLUME * EPI_DATA_T);
+				std::vector<float> motionParameters(6 * EPI_DATA_T);
+				GenerateMovingVolumes(&volumes[0], epiBlobs, EPI_DATA_W, EPI_DATA_H, EPI_DATA_D, EPI_DATA_T, SEED);
+
+				BROCCOLI.SetInputfMRIVolumes(&volumes[0]);
+				BROCCOLI.SetEPIWidth(EPI_DATA_W);
+				BROCCOLI.SetEPIHeight(EPI_DATA_H);
+				BROCCOLI.SetEPIDepth(EPI_DATA_D);
+				BROCCOLI.SetEPITimepoints(EPI_DATA_T);
+				BROCCOLI.SetEPIVoxelSizeX(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeY(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeZ(EPI_VOXEL_SIZE);
+				BROCCOLI.SetChangeMotionCorrectionReferenceVolume(false);
+				BROCCOLI.SetImageRegistrationFilterSize(FILTER_SIZE);
+				BROCCOLI.SetLinearImageRegistrationFilters(f, f + F, f + 2*F, f + 3*F, f + 4*F, f + 5*F);
+				BROCCOLI.SetNumberOfIterationsForMotionCorrection(5);
+				BROCCOLI.SetOutputMotionParameters(&motionParameters[0]);
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformMotionCorrectionWrapper();
+				endTime = GetWallTime();
+
+				results[stage].work = (double)EPI_VOLUME * (double)EPI_DATA_T;
+				results[stage].unit = "Mvoxels/s";
+			}
+			else if (stage == STAGE_SMOOTHING)
+			{
+				std::vector<float> volumes(EPI_VOLUME * EPI_DATA_T);
+				std::vector<float> certainty(EPI_VOLUME, 1.0f);
+				GenerateMovingVolumes(&volumes[0], epiBlobs, EPI_DATA_W, EPI_DATA_H, EPI_DATA_D, EPI_DATA_T, SEED);
+
+				BROCCOLI.SetInputfMRIVolumes(&volumes[0]);
+				BROCCOLI.SetAutoMask(false);
+				BROCCOLI.SetInputCertainty(&certainty[0]);
+				BROCCOLI.SetEPISmoothingAmount(6.0f);
+				BROCCOLI.SetEPIWidth(EPI_DATA_W);
+				BROCCOLI.SetEPIHeight(EPI_DATA_H);
+				BROCCOLI.SetEPIDepth(EPI_DATA_D);
+				BROCCOLI.SetEPITimepoints(EPI_DATA_T);
+				BROCCOLI.SetEPIVoxelSizeX(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeY(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeZ(EPI_VOXEL_SIZE);
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformSmoothingNormalizedHostWrapper();
+				endTime = GetWallTime();
+
+				results[stage].work = (double)EPI_VOLUME * (double)EPI_DATA_T;
+				results[stage].unit = "Mvoxels/s";
+			}
+			else if (stage == STAGE_FIRST_LEVEL_GLM)
+			{
+				size_t NUMBER_OF_GLM_REGRESSORS = 2;
+				size_t NUMBER_OF_DETRENDING_REGRESSORS = 4;
+				size_t NUMBER_OF_CONTRASTS = 1;
+				size_t NUMBER_OF_TOTAL_GLM_REGRESSORS = NUMBER_OF_GLM_REGRESSORS + NUMBER_OF_DETRENDING_REGRESSORS;
+				size_t DATA_T_PER_RUN[1] = {(size_t)EPI_DATA_T};
+
+				std::vector<float> volumes(EPI_VOLUME * EPI_DATA_T);
+				std::vector<float> X(EPI_DATA_T * NUMBER_OF_GLM_REGRESSORS);
+				std::vector<float> xtxxt(EPI_DATA_T * NUMBER_OF_GLM_REGRESSORS, 0.0f);
+				std::vector<float> contrasts(NUMBER_OF_GLM_REGRESSORS * NUMBER_OF_CONTRASTS, 0.0f);
+				std::vector<float> ctxtxc(NUMBER_OF_CONTRASTS, 0.0f);
+				std::vector<float> designMatrix(NUMBER_OF_TOTAL_GLM_REGRESSORS * EPI_DATA_T);
+				std::vector<float> designMatrix2(NUMBER_OF_TOTAL_GLM_REGRESSORS * EPI_DATA_T);
+				std::vector<float> mask(EPI_VOLUME);
+				std::vector<float> betas(EPI_VOLUME * NUMBER_OF_TOTAL_GLM_REGRESSORS);
+				std::vector<float> contrastVolumes(EPI_VOLUME * NUMBER_OF_CONTRASTS);
+				std::vector<float> statisticalMaps(EPI_VOLUME * NUMBER_OF_CONTRASTS);
+				std::vector<float> residualVariances(EPI_VOLUME);
+				std::vector<float> AR1(EPI_VOLUME), AR2(EPI_VOLUME), AR3(EPI_VOLUME), AR4(EPI_VOLUME);
+				contrasts[0] = 1.0f;
+
+				GenerateActivityVolumes(&volumes[0], &X[0], epiBlobs, EPI_DATA_W, EPI_DATA_H, EPI_DATA_D, EPI_DATA_T, SEED);
+
+				BROCCOLI.SetNumberOfGLMRegressors(NUMBER_OF_GLM_REGRESSORS);
+				BROCCOLI.SetNumberOfContrasts(NUMBER_OF_CONTRASTS);
+				BROCCOLI.SetDesignMatrix(&X[0], &xtxxt[0]);
+				BROCCOLI.SetContrasts(&contrasts[0]);
+				BROCCOLI.SetGLMScalars(&ctxtxc[0]);
+				BROCCOLI.SetRawRegressors(false);
+				BROCCOLI.SetRawDesignMatrix(false);
+				BROCCOLI.SetSaveDesignMatrix(false);
+				BROCCOLI.SetSaveResidualsEPI(false);
+				BROCCOLI.SetSaveResidualsMNI(false);
+				BROCCOLI.SetSaveResidualVariances(false);
+				BROCCOLI.SetOutputDesignMatrix(&designMatrix[0], &designMatrix2[0]);
+				BROCCOLI.SetOutputResidualVariances(&residualVariances[0]);
+				BROCCOLI.SetBetasOnly(false);
+				BROCCOLI.SetContrastsOnly(false);
+				BROCCOLI.SetBetasAndContrastsOnly(false);
+
+				BROCCOLI.SetInputfMRIVolumes(&volumes[0]);
+				BROCCOLI.SetOutputEPIMask(&mask[0]);
+				BROCCOLI.SetOutputMotionParameters(NULL);
+				BROCCOLI.SetEPIWidth(EPI_DATA_W);
+				BROCCOLI.SetEPIHeight(EPI_DATA_H);
+				BROCCOLI.SetEPIDepth(EPI_DATA_D);
+				BROCCOLI.SetEPITimepoints(EPI_DATA_T);
+				BROCCOLI.SetEPITimepointsPerRun(DATA_T_PER_RUN);
+				BROCCOLI.SetEPITR(2.0f);
+				BROCCOLI.SetNumberOfRuns(1);
+				BROCCOLI.SetEPIVoxelSizeX(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeY(EPI_VOXEL_SIZE);
+				BROCCOLI.SetEPIVoxelSizeZ(EPI_VOXEL_SIZE);
+				BROCCOLI.SetNumberOfDetrendingRegressors(NUMBER_OF_DETRENDING_REGRESSORS);
+				BROCCOLI.SetARSmoothingAmount(6.0f);
+				BROCCOLI.SetTemporalDerivatives(0);
+				BROCCOLI.SetRegressMotion(0);
+				BROCCOLI.SetRegressGlobalMean(0);
+				BROCCOLI.SetOutputBetaVolumesEPI(&betas[0]);
+				BROCCOLI.SetOutputContrastVolumesEPI(&contrastVolumes[0]);
+				BROCCOLI.SetOutputStatisticalMapsEPI(&statisticalMaps[0]);
+				BROCCOLI.SetOutputResidualsEPI(NULL);
+				BROCCOLI.SetOutputAREstimatesEPI(&AR1[0], &AR2[0], &AR3[0], &AR4[0]);
+				BROCCOLI.SetStatisticalTest(0); // t-test
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformGLMTTestFirstLevelWrapper();
+				endTime = GetWallTime();
+
+				results[stage].work = (double)EPI_VOLUME * (double)EPI_DATA_T;
+				results[stage].unit = "Mvoxels/s";
+			}
+			else if (stage == STAGE_PERMUTATION)
+			{
+				size_t NUMBER_OF_PERMUTATIONS_PER_CONTRAST[1] = {NUMBER_OF_PERMUTATIONS};
+				int GROUP_DESIGNS[1] = {2}; // Group mean
+				int NUMBER_OF_SUBJECTS_IN_GROUP1[1] = {NUMBER_OF_SUBJECTS};
+				int NUMBER_OF_SUBJECTS_IN_GROUP2[1] = {0};
+
+				std::vector<float> volumes(MNI_VOLUME * NUMBER_OF_SUBJECTS);
+				std::vector<float> mask(MNI_VOLUME);
+				std::vector<float> X(NUMBER_OF_SUBJECTS, 1.0f);
+				std::vector<float> xtxxt(NUMBER_OF_SUBJECTS, 1.0f / (float)NUMBER_OF_SUBJECTS);
+				float contrasts[1] = {1.0f};
+				float ctxtxc[1] = {1.0f / (float)NUMBER_OF_SUBJECTS};
+				std::vector<float> signMatrix(NUMBER_OF_PERMUTATIONS * NUMBER_OF_SUBJECTS);
+				std::vector<float> permutationDistribution(NUMBER_OF_PERMUTATIONS);
+				float* permutationDistributions[1] = {&permutationDistribution[0]};
+				std::vector<float> statisticalMaps(MNI_VOLUME);
+				std::vector<float> pValues(MNI_VOLUME);
+
+				GenerateGroupVolumes(&volumes[0], &mask[0], mniBlobs, MNI_DATA_W, MNI_DATA_H, MNI_DATA_D, NUMBER_OF_SUBJECTS, SEED);
+
+				BROCCOLI.SetInputFirstLevelResults(&volumes[0]);
+				BROCCOLI.SetInputMNIBrainMask(&mask[0]);
+				BROCCOLI.SetMNIWidth(MNI_DATA_W);
+				BROCCOLI.SetMNIHeight(MNI_DATA_H);
+				BROCCOLI.SetMNIDepth(MNI_DATA_D);
+				BROCCOLI.SetInferenceMode(VOXEL);
+				BROCCOLI.SetClusterDefiningThreshold(2.5f);
+				BROCCOLI.SetSignificanceLevel(0.05f);
+				BROCCOLI.SetNumberOfSubjects(NUMBER_OF_SUBJECTS);
+				BROCCOLI.SetNumberOfSubjectsGroup1(NUMBER_OF_SUBJECTS_IN_GROUP1);
+				BROCCOLI.SetNumberOfSubjectsGroup2(NUMBER_OF_SUBJECTS_IN_GROUP2);
+				BROCCOLI.SetNumberOfPermutations(NUMBER_OF_PERMUTATIONS);
+				BROCCOLI.SetNumberOfGroupPermutations(NUMBER_OF_PERMUTATIONS_PER_CONTRAST);
+				BROCCOLI.SetNumberOfGLMRegressors(1);
+				BROCCOLI.SetNumberOfContrasts(1);
+				BROCCOLI.SetDesignMatrix(&X[0], &xtxxt[0]);
+				BROCCOLI.SetContrasts(contrasts);
+				BROCCOLI.SetGLMScalars(ctxtxc);
+				BROCCOLI.SetOutputStatisticalMapsMNI(&statisticalMaps[0]);
+				BROCCOLI.SetOutputPermutationDistributions(permutationDistributions);
+				BROCCOLI.SetOutputPValuesMNI(&pValues[0]);
+				BROCCOLI.SetDoAllPermutations(false);
+				BROCCOLI.SetPermutationFileUsage(false);
+				BROCCOLI.SetGroupDesigns(GROUP_DESIGNS);
+				BROCCOLI.SetSignMatrix(&signMatrix[0]);
+				BROCCOLI.SetStatisticalTest(2); // Group mean
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformMeanSecondLevelPermutationWrapper();
+				endTime = GetWallTime();
+
+				results[stage].work = (double)NUMBER_OF_PERMUTATIONS * 1e6;
+				results[stage].unit = "permutations/s";
+			}
+			else if ( (stage == STAGE_BAYESIAN) || (stage == STAGE_VARIATIONAL_BAYES) )
+			{
+				int NUMBER_OF_GLM_REGRESSORS = 2;
+				int NUMBER_OF_CONTRASTS = 3;
+
+				std::vector<float> volumes(EPI_VOLUME * EPI_DATA_T);
+				std::vector<float> X(EPI_DATA_T * NUMBER_OF_GLM_REGRESSORS);
+				std::vector<float> xtxxt(EPI_DATA_T * NUMBER_OF_GLM_REGRESSORS, 0.0f);
+				std::vector<float> mask(EPI_VOLUME);
+				std::vector<float> betas(EPI_VOLUME * NUMBER_OF_GLM_REGRESSORS);
+				std::vector<float> PPMs(EPI_VOLUME * NUMBER_OF_CONTRASTS);
+				std::vector<float> AR1(EPI_VOLUME), AR2(EPI_VOLUME), AR3(EPI_VOLUME), AR4(EPI_VOLUME);
+				float contrasts[6] = {1.0f, 0.0f,   0.0f, 1.0f,   1.0f, -1.0f};
+
+				GenerateActivityVolumes(&volumes[0], &X[0], epiBlobs, EPI_DATA_W, EPI_DATA_H, EPI_DATA_D, EPI_DATA_T, SEED);
+
+				// The sampler only runs for brain voxels
+				for (size_t i = 0; i < EPI_VOLUME; i++)
+				{
+					mask[i] = (volumes[i] >= 500.0f) ? 1.0f : 0.0f;
+				}
+
+				BROCCOLI.SetInputfMRIVolumes(&volumes[0]);
+				BROCCOLI.SetEPIMask(&mask[0]);
+				BROCCOLI.SetEPIWidth(EPI_DATA_W);
+				BROCCOLI.SetEPIHeight(EPI_DATA_H);
+				BROCCOLI.SetEPIDepth(EPI_DATA_D);
+				BROCCOLI.SetEPITimepoints(EPI_DATA_T);
+				BROCCOLI.SetNumberOfGLMRegressors(NUMBER_OF_GLM_REGRESSORS);
+				BROCCOLI.SetNumberOfContrasts(NUMBER_OF_CONTRASTS);
+				BROCCOLI.SetDesignMatrix(&X[0], &xtxxt[0]);
+				BROCCOLI.SetContrasts(contrasts);
+				BROCCOLI.SetNumberOfDetrendingRegressors(4);
+				BROCCOLI.SetNumberOfMCMCIterations(NUMBER_OF_MCMC_ITERATIONS);
+				BROCCOLI.SetMCMCSeed(SEED);
+				BROCCOLI.SetBayesianMethod(stage == STAGE_BAYESIAN ? BAYESIAN_MCMC : BAYESIAN_VARIATIONAL);
+				BROCCOLI.SetOutputBetaVolumesEPI(&betas[0]);
+				BROCCOLI.SetOutputStatisticalMapsEPI(&PPMs[0]);
+				BROCCOLI.SetOutputAREstimatesEPI(&AR1[0], &AR2[0], &AR3[0], &AR4[0]);
+
+				BROCCOLI.ClearProfilingTimeline();
+				startTime = GetWallTime();
+				BROCCOLI.PerformBayesianFirstLevelWrapper();
+				endTime = GetWallTime();
+
+				if (stage == STAGE_BAYESIAN)
+				{
+					// Every brain voxel runs its own chain, including 10% burn in
+					int NUMBER_OF_DRAWS = NUMBER_OF_MCMC_ITERATIONS + (int)round((float)NUMBER_OF_MCMC_ITERATIONS * 0.1f);
+					results[stage].work = (double)NUMBER_OF_DRAWS * 1e6;
+					results[stage].unit = "draws/voxel/s";
+				}
+				else
+				{
+					// Same unit as the frequentist GLM, to compare the two directly
+					results[stage].work = (double)EPI_VOLUME * (double)EPI_DATA_T;
+					results[stage].unit = "Mvoxels/s";
+				}
+			}
+
+			results[stage].wallTimes.push_back(endTime - startTime);
+			results[stage].deviceTime = BROCCOLI.GetProfilingDeviceTime();
+			results[stage].transferredMB = (double)BROCCOLI.GetProfilingTransferredBytes() / (1024.0 * 1024.0);
+
+			PrintRunKernelErrors(BROCCOLI, stageNames[stage]);
+		}
+
+		// Timeline and summary of the last repetition
+		if (VERBOS)
+		{
+			printf("\nStage %s \n",stageNames[stage]);
+			BROCCOLI.PrintProfilingSummary();
+		}
+
+		if (TRACE_PREFIX != NULL)
+		{
+			std::string filename = TRACE_PREFIX;
+			filename.append("_");
+			filename.append(stageNames[stage]);
+			filename.append(".json");
+			if (!BROCCOLI.SaveProfilingTimeline(filename.c_str()))
+			{
+				printf("Could not open %s for writing!\n",filename.c_str());
+			}
+		}
+	}
+
+	// Print results
+	printf("\nPlatform: %s, device: %s, seed: %u, repetitions: %i \n\n",platformName.c_str(),deviceName.c_str(),SEED,REPETITIONS);
+	printf("%-18s %12s %12s %12s %12s %18s\n","Stage","Min (s)","Mean (s)","Device (s)","Transfer MB","Throughput");
+
+	std::ofstream output;
+	if (OUTPUT_FILE != NULL)
+	{
+		output.open(OUTPUT_FILE, std::ios::app);
+		if (!output.good())
+		{
+			printf("Could not open %s for writing!\n",OUTPUT_FILE);
+		}
+	}
+
+	for (int stage = 0; stage < NUMBER_OF_STAGES; stage++)
+	{
+		if (!results[stage].run)
+		{
+			continue;
+		}
+
+		std::vector<double>& times = results[stage].wallTimes;
+		double minTime = *std::min_element(times.begin(), times.end());
+		double meanTime = 0.0;
+		for (size_t t = 0; t < times.size(); t++)
+		{
+			meanTime += times[t] / (double)times.size();
+		}
+		double throughput = results[stage].work / minTime / 1e6;
+
+		printf("%-18s %12.4f %12.4f %12.4f %12.2f %10.2f %s\n",stageNames[stage],minTime,meanTime,results[stage].deviceTime,results[stage].transferredMB,throughput,results[stage].unit);
+
+		if (output.is_open() && output.good())
+		{
+			output << deviceName << "\t" << stageNames[stage] << "\t" << SEED << "\t" << minTime << "\t" << meanTime << "\t" << results[stage].deviceTime << "\t" << results[stage].transferredMB << "\t" << throughput << "\t" << results[stage].unit << std::endl;
+		}
+	}
+
+	if (output.is_open())
+	{
+		output.close();
+	}
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,458 @@
+/*
+ * BROCCOLI: Software for Fast fMRI Analysis on Many-Core CPUs and GPUs
+ * Copyright (C) <2013>  Anders Eklund, andek034@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the accuracy of the first level permutation test when the whitened and the permuted
+// volumes are stored as half floats (SetStoragePrecision(STORAGE_HALF)). Simulated AR(4) time series
+// are whitened, scaled, permuted and inverse whitened in the same way as in the kernels, once with
+// float storage and once with half storage, and the resulting t-values are compared.
+// The original data of the first level GLM blocks (CalculateStatisticalMapsGLMFirstLevelBlocks) can also be
+// stored as half floats, the t-values of the unwhitened simulated data are compared for this case.
+// Only the host is used, no OpenCL device is needed.
+
+#include "broccoli_lib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+// Float to half float, round to nearest even, same as vstore_half with the default rounding mode
+unsigned short FloatToHalf(float value)
+{
+	unsigned int x;
+	memcpy(&x, &value, sizeof(float));
+
+	unsigned short sign = (unsigned short)((x >> 16) & 0x8000);
+	int exponent = (int)((x >> 23) & 0xff) - 127 + 15;
+	unsigned int mantissa = x & 0x7fffff;
+
+	// NaN
+	if ((x & 0x7fffffff) > 0x7f800000)
+	{
+		return sign | 0x7e00;
+	}
+
+	// Overflow, infinity
+	if (exponent >= 31)
+	{
+		return sign | 0x7c00;
+	}
+
+	// Subnormal half or zero
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+		{
+			return sign;
+		}
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		unsigned int halfMantissa = mantissa >> shift;
+		unsigned int remainder = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if ( (remainder > halfway) || ((remainder == halfway) && (halfMantissa & 1)) )
+		{
+			halfMantissa++;
+		}
+		return sign | (unsigned short)halfMantissa;
+	}
+
+	unsigned short half = sign | (unsigned short)(exponent << 10) | (unsigned short)(mantissa >> 13);
+	unsigned int remainder = mantissa & 0x1fff;
+	if ( (remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)) )
+	{
+		// A carry into the exponent gives the correct result, also for overflow to infinity
+		half++;
+	}
+	return half;
+}
+
+// Half float to float, same as vload_half
+float HalfToFloat(unsigned short half)
+{
+	unsigned int sign = (unsigned int)(half & 0x8000) << 16;
+	unsigned int exponent = (half >> 10) & 0x1f;
+	unsigned int mantissa = half & 0x3ff;
+	unsigned int x;
+
+	if (exponent == 0)
+	{
+		float value = ldexpf((float)mantissa, -24);
+		return sign ? -value : value;
+	}
+	else if (exponent == 31)
+	{
+		x = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else
+	{
+		x = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float value;
+	memcpy(&value, &x, sizeof(float));
+	return value;
+}
+
+float StoreAndLoad(float value, bool half)
+{
+	if (half)
+	{
+		return HalfToFloat(FloatToHalf(value));
+	}
+	return value;
+}
+
+float RandomNormal()
+{
+	float u1 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+	float u2 = ((float)rand() + 1.0f) / ((float)RAND_MAX + 2.0f);
+	return sqrtf(-2.0f * logf(u1)) * cosf(2.0f * (float)PI * u2);
+}
+
+// t-value for the activation regressor, the model is an intercept and a block design,
+// accumulation in float as in CalculateStatisticalMapsGLMTTestFirstLevelPermutationFused
+float CalculateTValue(const float* h_Timeseries, const float* h_X, const float* h_xtxxt, float ctxtxc, int DATA_T)
+{
+	float beta[2] = {0.0f, 0.0f};
+	for (int t = 0; t < DATA_T; t++)
+	{
+		beta[0] += h_xtxxt[t] * h_Timeseries[t];
+		beta[1] += h_xtxxt[t + DATA_T] * h_Timeseries[t];
+	}
+
+	float sumSquares = 0.0f;
+	for (int t = 0; t < DATA_T; t++)
+	{
+		float residual = h_Timeseries[t] - beta[0] * h_X[t] - beta[1] * h_X[t + DATA_T];
+		sumSquares += residual * residual;
+	}
+	float variance = sumSquares / ((float)DATA_T - 2.0f);
+
+	return beta[1] / sqrtf(variance * ctxtxc);
+}
+
+int main(int argc, char **argv)
+{
+	int				DATA_W = 64;
+	int				DATA_H = 64;
+	int				DATA_D = 33;
+	int				DATA_T = 200;
+	int				NUMBER_OF_VOXELS = 10000;
+	int				NUMBER_OF_PERMUTATIONS = 20;
+
+    // Print help text, the defaults are used if there are no inputs
+    if ( (argc == 2) && (strcmp(argv[1],"-help") == 0) )
+    {
+        printf("Usage:\n\n");
+        printf("HalfPrecisionBenchmark [options]\n\n");
+        printf("Options:\n\n");
+        printf(" -width              Width of the 4D dataset, for the memory usage (default 64) \n");
+        printf(" -height             Height of the 4D dataset, for the memory usage (default 64) \n");
+        printf(" -depth              Depth of the 4D dataset, for the memory usage (default 33) \n");
+        printf(" -timepoints         Number of volumes (default 200) \n");
+        printf(" -voxels             Number of simulated voxels (default 10000) \n");
+        printf(" -permutations       Number of permutations (default 20) \n");
+        printf("\n\n");
+
+        return EXIT_SUCCESS;
+    }
+
+ 	// Loop over inputs
+    int i = 1;
+    while (i < argc)
+    {
+        char *input = argv[i];
+        char *p;
+        if ( (strcmp(input,"-width") == 0) || (strcmp(input,"-height") == 0) || (strcmp(input,"-depth") == 0) || (strcmp(input,"-timepoints") == 0) || (strcmp(input,"-voxels") == 0) || (strcmp(input,"-permutations") == 0) )
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after %s !\n",input);
+                return EXIT_FAILURE;
+			}
+
+            long value = strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("%s must be an integer! You provided %s \n",input,argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            else if (value <= 0)
+            {
+                printf("Invalid value for %s ! You provided %s \n",input,argv[i+1]);
+                return EXIT_FAILURE;
+            }
+
+			if (strcmp(input,"-width") == 0)
+				DATA_W = (int)value;
+			else if (strcmp(input,"-height") == 0)
+				DATA_H = (int)value;
+			else if (strcmp(input,"-depth") == 0)
+				DATA_D = (int)value;
+			else if (strcmp(input,"-timepoints") == 0)
+				DATA_T = (int)value;
+			else if (strcmp(input,"-voxels") == 0)
+				NUMBER_OF_VOXELS = (int)value;
+			else if (strcmp(input,"-permutations") == 0)
+				NUMBER_OF_PERMUTATIONS = (int)value;
+            i += 2;
+        }
+        else
+        {
+            printf("Unrecognized option! %s \n",argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+	if (DATA_T < 20)
+	{
+		printf("At least 20 time points are needed! \n");
+		return EXIT_FAILURE;
+	}
+
+	// Make sure that the conversions are exact for all half values
+	int roundTripErrors = 0;
+	for (unsigned int h = 0; h < 65536; h++)
+	{
+		unsigned short half = (unsigned short)h;
+		if ( (((half >> 10) & 0x1f) == 31) && ((half & 0x3ff) != 0) )
+		{
+			continue;
+		}
+		if (FloatToHalf(HalfToFloat(half)) != half)
+		{
+			roundTripErrors++;
+		}
+	}
+
+	// Design matrix, intercept and a block design with 10 volumes off and 10 volumes on
+	std::vector<float> h_X(2 * DATA_T), h_xtxxt(2 * DATA_T);
+	for (int t = 0; t < DATA_T; t++)
+	{
+		h_X[t] = 1.0f;
+		h_X[t + DATA_T] = ((t / 10) % 2 == 1) ? 1.0f : 0.0f;
+	}
+
+	double xtx[4] = {0.0, 0.0, 0.0, 0.0};
+	for (int t = 0; t < DATA_T; t++)
+	{
+		xtx[0] += h_X[t] * h_X[t];
+		xtx[1] += h_X[t] * h_X[t + DATA_T];
+		xtx[3] += h_X[t + DATA_T] * h_X[t + DATA_T];
+	}
+	xtx[2] = xtx[1];
+	double determinant = xtx[0] * xtx[3] - xtx[1] * xtx[2];
+	double inv_xtx[4] = {xtx[3] / determinant, -xtx[1] / determinant, -xtx[2] / determinant, xtx[0] / determinant};
+	for (int t = 0; t < DATA_T; t++)
+	{
+		h_xtxxt[t] = (float)(inv_xtx[0] * h_X[t] + inv_xtx[1] * h_X[t + DATA_T]);
+		h_xtxxt[t + DATA_T] = (float)(inv_xtx[2] * h_X[t] + inv_xtx[3] * h_X[t + DATA_T]);
+	}
+	float ctxtxc = (float)inv_xtx[3];
+
+	srand(1234);
+
+	// Simulate voxels with an AR(4) noise process, a baseline and a weak activation,
+	// the data are regressed and whitened in float, as in PerformWhiteningPriorPermutationsSlices
+	std::vector<float> h_AR(4 * NUMBER_OF_VOXELS);
+	std::vector<float> h_Whitened(NUMBER_OF_VOXELS * DATA_T);
+	std::vector<float> h_Original(NUMBER_OF_VOXELS * DATA_T), h_Original_Means(NUMBER_OF_VOXELS);
+	std::vector<float> h_Timeseries(DATA_T);
+	float maxAbs = 0.0f, maxAbsOriginal = 0.0f;
+
+	for (int v = 0; v < NUMBER_OF_VOXELS; v++)
+	{
+		float* ar = &h_AR[4 * v];
+		ar[0] = 0.2f + 0.3f * (float)rand() / (float)RAND_MAX;
+		ar[1] = 0.1f * (float)rand() / (float)RAND_MAX;
+		ar[2] = 0.05f * (float)rand() / (float)RAND_MAX;
+		ar[3] = 0.05f * (float)rand() / (float)RAND_MAX;
+
+		float baseline = 500.0f + 1000.0f * (float)rand() / (float)RAND_MAX;
+		float sigma = 5.0f + 20.0f * (float)rand() / (float)RAND_MAX;
+		float activation = (v % 4 == 0) ? 0.5f * sigma : 0.0f;
+
+		for (int t = 0; t < DATA_T; t++)
+		{
+			float noise = sigma * RandomNormal();
+			for (int k = 0; k < 4; k++)
+			{
+				if (t - k - 1 >= 0)
+				{
+					noise += ar[k] * (h_Timeseries[t - k - 1] - baseline - activation * h_X[t - k - 1 + DATA_T]);
+				}
+			}
+			h_Timeseries[t] = baseline + activation * h_X[t + DATA_T] + noise;
+			h_Original[t + v * DATA_T] = h_Timeseries[t];
+		}
+
+		// The mean of each voxel is stored as a float, only the deviations from the mean are stored as half floats
+		float mean = 0.0f;
+		for (int t = 0; t < DATA_T; t++)
+		{
+			mean += h_Timeseries[t];
+		}
+		mean /= (float)DATA_T;
+		h_Original_Means[v] = mean;
+		for (int t = 0; t < DATA_T; t++)
+		{
+			maxAbsOriginal = std::max(maxAbsOriginal, fabsf(h_Timeseries[t] - mean));
+		}
+
+		// Remove the fit of the model
+		float beta0 = 0.0f, beta1 = 0.0f;
+		for (int t = 0; t < DATA_T; t++)
+		{
+			beta0 += h_xtxxt[t] * h_Timeseries[t];
+			beta1 += h_xtxxt[t + DATA_T] * h_Timeseries[t];
+		}
+		for (int t = 0; t < DATA_T; t++)
+		{
+			h_Timeseries[t] -= beta0 * h_X[t] + beta1 * h_X[t + DATA_T];
+		}
+
+		// Whitening, same as ApplyWhiteningAR4
+		for (int t = 0; t < DATA_T; t++)
+		{
+			float value = h_Timeseries[t];
+			for (int k = 0; k < 4; k++)
+			{
+				if (t - k - 1 >= 0)
+				{
+					value -= ar[k] * h_Timeseries[t - k - 1];
+				}
+			}
+			h_Whitened[t + v * DATA_T] = value;
+			maxAbs = std::max(maxAbs, fabsf(value));
+		}
+	}
+
+	float scale = HALF_STORAGE_MAX_VALUE / maxAbs;
+
+	// Same permutations for both storage precisions
+	std::vector<int> h_Permutation(DATA_T);
+	std::vector<float> h_Permuted[2];
+	h_Permuted[0].resize(DATA_T);
+	h_Permuted[1].resize(DATA_T);
+
+	double maxDifference = 0.0, sumDifference = 0.0, maxTValue = 0.0, maxMaxDifference = 0.0;
+	float maxPermutedValue = 0.0f;
+	size_t numberOfValues = 0;
+
+	for (int p = 0; p < NUMBER_OF_PERMUTATIONS; p++)
+	{
+		for (int t = 0; t < DATA_T; t++)
+		{
+			h_Permutation[t] = t;
+		}
+		std::random_shuffle(h_Permutation.begin(), h_Permutation.end());
+
+		float maxT[2] = {-1000.0f, -1000.0f};
+
+		for (int v = 0; v < NUMBER_OF_VOXELS; v++)
+		{
+			const float* ar = &h_AR[4 * v];
+			float tValues[2];
+
+			for (int precision = 0; precision < 2; precision++)
+			{
+				bool half = (precision == 1);
+				std::vector<float>& permuted = h_Permuted[precision];
+
+				// Permutation and inverse whitening, same as in CalculateStatisticalMapsGLMTTestFirstLevelPermutationFused(Half)
+				for (int t = 0; t < DATA_T; t++)
+				{
+					float value = StoreAndLoad(scale * h_Whitened[h_Permutation[t] + v * DATA_T], half);
+					for (int k = 0; k < 4; k++)
+					{
+						if (t - k - 1 >= 0)
+						{
+							value += ar[k] * permuted[t - k - 1];
+						}
+					}
+					permuted[t] = value;
+				}
+
+				// The permuted volumes are stored in global memory, the inverse whitening above reads the
+				// unrounded values from registers, as in the kernel
+				std::vector<float> stored(DATA_T);
+				for (int t = 0; t < DATA_T; t++)
+				{
+					stored[t] = StoreAndLoad(permuted[t], half);
+					if (half)
+					{
+						maxPermutedValue = std::max(maxPermutedValue, fabsf(permuted[t]));
+					}
+				}
+
+				tValues[precision] = CalculateTValue(&stored[0], &h_X[0], &h_xtxxt[0], ctxtxc, DATA_T);
+				maxT[precision] = std::max(maxT[precision], tValues[precision]);
+			}
+
+			double difference = fabs((double)tValues[1] - (double)tValues[0]);
+			maxDifference = std::max(maxDifference, difference);
+			maxTValue = std::max(maxTValue, fabs((double)tValues[0]));
+			sumDifference += difference;
+			numberOfValues++;
+		}
+
+		maxMaxDifference = std::max(maxMaxDifference, fabs((double)maxT[1] - (double)maxT[0]));
+	}
+
+	// Original data of the first level GLM, scaled as in CalculateStatisticalMapsGLMFirstLevelBlocks and converted
+	// back to float by the kernels
+	float scaleOriginal = HALF_STORAGE_MAX_VALUE / maxAbsOriginal;
+	double maxDifferenceGLM = 0.0, sumDifferenceGLM = 0.0;
+	std::vector<float> h_Loaded(DATA_T);
+	for (int v = 0; v < NUMBER_OF_VOXELS; v++)
+	{
+		for (int t = 0; t < DATA_T; t++)
+		{
+			h_Loaded[t] = h_Original_Means[v] + StoreAndLoad(scaleOriginal * (h_Original[t + v * DATA_T] - h_Original_Means[v]), true) / scaleOriginal;
+		}
+
+		float tFloat = CalculateTValue(&h_Original[v * DATA_T], &h_X[0], &h_xtxxt[0], ctxtxc, DATA_T);
+		float tHalf = CalculateTValue(&h_Loaded[0], &h_X[0], &h_xtxxt[0], ctxtxc, DATA_T);
+		double difference = fabs((double)tHalf - (double)tFloat);
+		maxDifferenceGLM = std::max(maxDifferenceGLM, difference);
+		sumDifferenceGLM += difference;
+	}
+
+	// The whitened and the permuted volumes
+	double floatMB = 2.0 * (double)DATA_W * DATA_H * DATA_D * DATA_T * sizeof(float) / 1024.0 / 1024.0;
+	double halfMB = 2.0 * (double)DATA_W * DATA_H * DATA_D * DATA_T * sizeof(unsigned short) / 1024.0 / 1024.0;
+
+	printf("Half round trip errors: %i \n",roundTripErrors);
+	printf("Simulated %i voxels, %i time points, %i permutations, scale %f, largest permuted value %f (half max 65504) \n\n",NUMBER_OF_VOXELS,DATA_T,NUMBER_OF_PERMUTATIONS,scale,maxPermutedValue);
+	printf("%-10s %26s %14s %14s %16s\n","Storage","Memory 4D buffers (MB)","max |dt|","mean |dt|","max |d max t|");
+	printf("%-10s %26.1f %14s %14s %16s\n","float",floatMB,"-","-","-");
+	printf("%-10s %26.1f %14.6f %14.6f %16.6f\n","half",halfMB,maxDifference,sumDifference / (double)numberOfValues,maxMaxDifference);
+	printf("\nLargest absolute t-value %f \n",maxTValue);
+
+	// The two buffers for the original data of each block of the first level GLM
+	printf("\nFirst level GLM, original data stored as half floats, scale %f \n\n",scaleOriginal);
+	printf("%-10s %26s %14s %14s\n","Storage","Memory original data (MB)","max |dt|","mean |dt|");
+	printf("%-10s %26.1f %14s %14s\n","float",floatMB,"-","-");
+	printf("%-10s %26.1f %14.6f %14.6f\n","half",halfMB,maxDifferenceGLM,sumDifferenceGLM / (double)NUMBER_OF_VOXELS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,314 @@
+/*
+ * BROCCOLI: Software for Fast fMRI Analysis on Many-Core CPUs and GPUs
+ * Copyright (C) <2013>  Anders Eklund, andek034@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Compares the interpolation modes of the linear transformation (nearest, linear, cubic, B-spline, Lanczos).
+// A synthetic volume is rotated forth and back, the error compared to the original volume measures the accuracy
+// (blurring and ringing) and the time of the transformations measures the throughput.
+
+#include "broccoli_lib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+
+#define NUMBER_OF_MODES 5
+
+double GetWallTime()
+{
+    struct timeval time;
+    if (gettimeofday(&time,NULL))
+    {
+        //  Handle error
+        return 0;
+    }
+    return (double)time.tv_sec + (double)time.tv_usec * .000001;
+}
+
+bool CheckInitialization(BROCCOLI_LIB& BROCCOLI)
+{
+	if (!BROCCOLI.GetOpenCLInitiated())
+	{
+		printf("Initialization error is \"%s\" \n",BROCCOLI.GetOpenCLInitializationError().c_str());
+		printf("OpenCL error is \"%s\" \n",BROCCOLI.GetOpenCLError());
+		printf("OpenCL initialization failed, aborting! \n");
+		return false;
+	}
+	return true;
+}
+
+void PrintRunKernelErrors(BROCCOLI_LIB& BROCCOLI, const char* mode)
+{
+	int* runKernelErrors = BROCCOLI.GetOpenCLRunKernelErrors();
+	for (int i = 0; i < BROCCOLI.GetNumberOfOpenCLKernels(); i++)
+	{
+		if (runKernelErrors[i] != 0)
+		{
+			printf("Run kernel error for mode %s for kernel '%s' is '%s' \n",mode,BROCCOLI.GetOpenCLKernelName(i),BROCCOLI.GetOpenCLErrorMessage(runKernelErrors[i]));
+		}
+	}
+}
+
+// Smooth blobs plus a sinusoidal texture, which is close to the highest frequency that can be represented
+void GenerateVolume(float* h_Volume, int DATA_W, int DATA_H, int DATA_D)
+{
+	float cx = (float)(DATA_W - 1) / 2.0f;
+	float cy = (float)(DATA_H - 1) / 2.0f;
+	float cz = (float)(DATA_D - 1) / 2.0f;
+
+	for (int z = 0; z < DATA_D; z++)
+	{
+		for (int y = 0; y < DATA_H; y++)
+		{
+			for (int x = 0; x < DATA_W; x++)
+			{
+				float dx = ((float)x - cx) / (float)DATA_W;
+				float dy = ((float)y - cy) / (float)DATA_H;
+				float dz = ((float)z - cz) / (float)DATA_D;
+
+				float value = 1000.0f * expf(-(dx*dx + dy*dy + dz*dz) / 0.05f);
+				value += 300.0f * expf(-((dx - 0.15f)*(dx - 0.15f) + dy*dy + dz*dz) / 0.002f);
+				value += 100.0f * sinf(0.8f * (float)x) * sinf(0.6f * (float)y);
+
+				h_Volume[x + y * DATA_W + z * DATA_W * DATA_H] = value;
+			}
+		}
+	}
+}
+
+// Rotation around the z-axis, the affine parameters are the matrix minus identity
+void RotationParameters(float* h_Parameters, float angle)
+{
+	for (int i = 0; i < 12; i++)
+	{
+		h_Parameters[i] = 0.0f;
+	}
+
+	h_Parameters[3] = cosf(angle) - 1.0f;
+	h_Parameters[4] = -sinf(angle);
+	h_Parameters[6] = sinf(angle);
+	h_Parameters[7] = cosf(angle) - 1.0f;
+}
+
+int main(int argc, char **argv)
+{
+    int             OPENCL_PLATFORM = 0;
+    int             OPENCL_DEVICE = 0;
+	int				DATA_W = 128;
+	int				DATA_H = 128;
+	int				DATA_D = 64;
+	int				DATA_T = 10;
+	int				DEGREES = 15;
+	int				REPETITIONS = 3;
+
+    // Print help text, the defaults are used if there are no inputs
+    if ( (argc == 2) && (strcmp(argv[1],"-help") == 0) )
+    {
+        printf("Usage:\n\n");
+        printf("InterpolationBenchmark [options]\n\n");
+        printf("Options:\n\n");
+        printf(" -platform           The OpenCL platform to use (default 0) \n");
+        printf(" -device             The OpenCL device to use for the specificed platform (default 0) \n");
+        printf(" -width              Width of the volumes (default 128) \n");
+        printf(" -height             Height of the volumes (default 128) \n");
+        printf(" -depth              Depth of the volumes (default 64) \n");
+        printf(" -timepoints         Number of volumes transformed by each call (default 10) \n");
+        printf(" -degrees            Rotation around the z-axis, in degrees (default 15) \n");
+        printf(" -repetitions        Number of runs of each interpolation mode (default 3) \n");
+        printf("\n\n");
+
+        return EXIT_SUCCESS;
+    }
+
+ 	// Loop over inputs
+    int i = 1;
+    while (i < argc)
+    {
+        char *input = argv[i];
+        char *p;
+        if ( (strcmp(input,"-platform") == 0) || (strcmp(input,"-device") == 0) || (strcmp(input,"-width") == 0) || (strcmp(input,"-height") == 0) || (strcmp(input,"-depth") == 0) || (strcmp(input,"-timepoints") == 0) || (strcmp(input,"-degrees") == 0) || (strcmp(input,"-repetitions") == 0) )
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after %s !\n",input);
+                return EXIT_FAILURE;
+			}
+
+            long value = strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("%s must be an integer! You provided %s \n",input,argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            else if ( (value < 0) || ((value == 0) && (strcmp(input,"-platform") != 0) && (strcmp(input,"-device") != 0)) )
+            {
+                printf("Invalid value for %s ! You provided %s \n",input,argv[i+1]);
+                return EXIT_FAILURE;
+            }
+
+			if (strcmp(input,"-platform") == 0)
+				OPENCL_PLATFORM = (int)value;
+			else if (strcmp(input,"-device") == 0)
+				OPENCL_DEVICE = (int)value;
+			else if (strcmp(input,"-width") == 0)
+				DATA_W = (int)value;
+			else if (strcmp(input,"-height") == 0)
+				DATA_H = (int)value;
+			else if (strcmp(input,"-depth") == 0)
+				DATA_D = (int)value;
+			else if (strcmp(input,"-timepoints") == 0)
+				DATA_T = (int)value;
+			else if (strcmp(input,"-degrees") == 0)
+				DEGREES = (int)value;
+			else if (strcmp(input,"-repetitions") == 0)
+				REPETITIONS = (int)value;
+            i += 2;
+        }
+        else
+        {
+            printf("Unrecognized option! %s \n",argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+	size_t VOLUME_SIZE = (size_t)DATA_W * DATA_H * DATA_D;
+	size_t N = VOLUME_SIZE * DATA_T;
+
+	float* h_Original_Volumes = (float*)malloc(N * sizeof(float));
+	float* h_Rotated_Volumes = (float*)malloc(N * sizeof(float));
+	float* h_Restored_Volumes = (float*)malloc(N * sizeof(float));
+	if ( (h_Original_Volumes == NULL) || (h_Rotated_Volumes == NULL) || (h_Restored_Volumes == NULL) )
+	{
+		printf("Could not allocate host memory!\n");
+		free(h_Original_Volumes);
+		free(h_Rotated_Volumes);
+		free(h_Restored_Volumes);
+		return EXIT_FAILURE;
+	}
+
+	GenerateVolume(h_Original_Volumes, DATA_W, DATA_H, DATA_D);
+	for (int t = 1; t < DATA_T; t++)
+	{
+		memcpy(&h_Original_Volumes[t * VOLUME_SIZE], h_Original_Volumes, VOLUME_SIZE * sizeof(float));
+	}
+
+	float angle = (float)DEGREES * 3.14159265f / 180.0f;
+	float h_Forward_Parameters[12], h_Inverse_Parameters[12];
+	RotationParameters(h_Forward_Parameters, angle);
+	RotationParameters(h_Inverse_Parameters, -angle);
+
+	// The error is only calculated inside a cylinder, which stays inside the volume for all rotations
+	float radius = 0.45f * (float)std::min(DATA_W, DATA_H) - 3.0f;
+	float cx = (float)(DATA_W - 1) / 2.0f;
+	float cy = (float)(DATA_H - 1) / 2.0f;
+
+	const int modes[NUMBER_OF_MODES] = {NEAREST, LINEAR, CUBIC, BSPLINE, LANCZOS};
+	const char* modeNames[NUMBER_OF_MODES] = {"Nearest", "Linear", "Cubic", "B-spline", "Lanczos"};
+
+	printf("Volumes %i x %i x %i x %i, rotation of %i degrees forth and back, best of %i runs \n\n",DATA_W,DATA_H,DATA_D,DATA_T,DEGREES,REPETITIONS);
+	printf("%-10s %14s %14s %14s %14s\n","Mode","Time (s)","Mvoxels/s","RMS error","Max error");
+
+	for (int mode = 0; mode < NUMBER_OF_MODES; mode++)
+	{
+		// New instance for each mode, so that no state is shared between the modes
+		BROCCOLI_LIB BROCCOLI(OPENCL_PLATFORM,OPENCL_DEVICE,2,false); // 2 = Bash wrapper
+		if (!CheckInitialization(BROCCOLI))
+		{
+			free(h_Original_Volumes);
+			free(h_Rotated_Volumes);
+			free(h_Restored_Volumes);
+			return EXIT_FAILURE;
+		}
+
+		// Same size and voxel size for input and reference, such that only the rotation changes the volumes
+		BROCCOLI.SetT1Width(DATA_W);
+		BROCCOLI.SetT1Height(DATA_H);
+		BROCCOLI.SetT1Depth(DATA_D);
+		BROCCOLI.SetT1Timepoints(DATA_T);
+		BROCCOLI.SetT1VoxelSizeX(1.0f);
+		BROCCOLI.SetT1VoxelSizeY(1.0f);
+		BROCCOLI.SetT1VoxelSizeZ(1.0f);
+
+		BROCCOLI.SetMNIWidth(DATA_W);
+		BROCCOLI.SetMNIHeight(DATA_H);
+		BROCCOLI.SetMNIDepth(DATA_D);
+		BROCCOLI.SetMNIVoxelSizeX(1.0f);
+		BROCCOLI.SetMNIVoxelSizeY(1.0f);
+		BROCCOLI.SetMNIVoxelSizeZ(1.0f);
+
+		BROCCOLI.SetMMT1ZCUT(0);
+		BROCCOLI.SetInterpolationMode(modes[mode]);
+
+		std::vector<double> times;
+		for (int r = 0; r < REPETITIONS; r++)
+		{
+			double startTime = GetWallTime();
+			BROCCOLI.SetInputT1Volume(h_Original_Volumes);
+			BROCCOLI.SetOutputT1MNIRegistrationParameters(h_Forward_Parameters);
+			BROCCOLI.SetOutputInterpolatedT1Volume(h_Rotated_Volumes);
+			BROCCOLI.TransformVolumesLinearWrapper();
+			times.push_back(GetWallTime() - startTime);
+		}
+
+		BROCCOLI.SetInputT1Volume(h_Rotated_Volumes);
+		BROCCOLI.SetOutputT1MNIRegistrationParameters(h_Inverse_Parameters);
+		BROCCOLI.SetOutputInterpolatedT1Volume(h_Restored_Volumes);
+		BROCCOLI.TransformVolumesLinearWrapper();
+
+		PrintRunKernelErrors(BROCCOLI, modeNames[mode]);
+
+		double sum = 0.0;
+		double maxError = 0.0;
+		size_t voxels = 0;
+		for (int z = 0; z < DATA_D; z++)
+		{
+			for (int y = 0; y < DATA_H; y++)
+			{
+				for (int x = 0; x < DATA_W; x++)
+				{
+					float dx = (float)x - cx;
+					float dy = (float)y - cy;
+					if ((dx*dx + dy*dy) > (radius * radius))
+					{
+						continue;
+					}
+
+					size_t idx = x + y * DATA_W + z * DATA_W * DATA_H;
+					double error = fabs((double)h_Restored_Volumes[idx] - (double)h_Original_Volumes[idx]);
+					sum += error * error;
+					maxError = std::max(maxError, error);
+					voxels++;
+				}
+			}
+		}
+
+		double time = *std::min_element(times.begin(), times.end());
+
+		printf("%-10s %14.4f %14.2f %14.4f %14.4f\n",modeNames[mode],time,(double)N / time / 1000000.0,sqrt(sum / (double)voxels),maxError);
+	}
+
+	free(h_Original_Volumes);
+	free(h_Rotated_Volumes);
+	free(h_Restored_Volumes);
+
+    return EXIT_SUCCESS;
+}
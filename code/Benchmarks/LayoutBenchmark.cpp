@@ -0,0 +1,266 @@
+/*
+ * BROCCOLI: Software for Fast fMRI Analysis on Many-Core CPUs and GPUs
+ * Copyright (C) <2013>  Anders Eklund, andek034@gmail.com
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Compares the in place storage order conversions of 4D datasets (ConvertLayout*)
+// with the original implementations that use a full size temporary copy (FlipVolumes*).
+// Only the host is used, no OpenCL device is needed.
+
+#include "broccoli_lib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <algorithm>
+#include <sys/time.h>
+
+double GetWallTime()
+{
+    struct timeval time;
+    if (gettimeofday(&time,NULL))
+    {
+        //  Handle error
+        return 0;
+    }
+    return (double)time.tv_sec + (double)time.tv_usec * .000001;
+}
+
+// Reference for x, y, z, t to t, x, y, z, written the same way as FlipVolumesXYZTtoXYTZ
+void FlipVolumesXYZTtoTXYZ(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T)
+{
+	float* h_Temp_Volumes = (float*)malloc(DATA_W * DATA_H * DATA_D * DATA_T * sizeof(float));
+
+	size_t i = 0;
+	for (size_t t = 0; t < DATA_T ; t++)
+	{
+		for (size_t z = 0; z < DATA_D ; z++)
+		{
+			for (size_t y = 0; y < DATA_H ; y++)
+			{
+				for (size_t x = 0; x < DATA_W ; x++)
+				{
+					h_Temp_Volumes[t + x * DATA_T + y * DATA_T * DATA_W + z * DATA_T * DATA_W * DATA_H] = h_Volumes[i];
+					i++;
+				}
+			}
+		}
+	}
+
+	memcpy(h_Volumes, h_Temp_Volumes, DATA_W * DATA_H * DATA_D * DATA_T * sizeof(float));
+	free(h_Temp_Volumes);
+}
+
+// Reference for t, x, y, z to x, y, z, t
+void FlipVolumesTXYZtoXYZT(float* h_Volumes, size_t DATA_W, size_t DATA_H, size_t DATA_D, size_t DATA_T)
+{
+	float* h_Temp_Volumes = (float*)malloc(DATA_W * DATA_H * DATA_D * DATA_T * sizeof(float));
+
+	size_t i = 0;
+	for (size_t z = 0; z < DATA_D ; z++)
+	{
+		for (size_t y = 0; y < DATA_H ; y++)
+		{
+			for (size_t x = 0; x < DATA_W ; x++)
+			{
+				for (size_t t = 0; t < DATA_T ; t++)
+				{
+					h_Temp_Volumes[x + y * DATA_W + z * DATA_W * DATA_H + t * DATA_W * DATA_H * DATA_D] = h_Volumes[i];
+					i++;
+				}
+			}
+		}
+	}
+
+	memcpy(h_Volumes, h_Temp_Volumes, DATA_W * DATA_H * DATA_D * DATA_T * sizeof(float));
+	free(h_Temp_Volumes);
+}
+
+int main(int argc, char **argv)
+{
+	int				DATA_W = 64;
+	int				DATA_H = 64;
+	int				DATA_D = 33;
+	int				DATA_T = 200;
+	int				REPETITIONS = 5;
+
+    // Print help text, the defaults are used if there are no inputs
+    if ( (argc == 2) && (strcmp(argv[1],"-help") == 0) )
+    {
+        printf("Usage:\n\n");
+        printf("LayoutBenchmark [options]\n\n");
+        printf("Options:\n\n");
+        printf(" -width              Width of the 4D dataset (default 64) \n");
+        printf(" -height             Height of the 4D dataset (default 64) \n");
+        printf(" -depth              Depth of the 4D dataset (default 33) \n");
+        printf(" -timepoints         Number of volumes (default 200) \n");
+        printf(" -repetitions        Number of runs of each conversion (default 5) \n");
+        printf("\n\n");
+
+        return EXIT_SUCCESS;
+    }
+
+ 	// Loop over inputs
+    int i = 1;
+    while (i < argc)
+    {
+        char *input = argv[i];
+        char *p;
+        if ( (strcmp(input,"-width") == 0) || (strcmp(input,"-height") == 0) || (strcmp(input,"-depth") == 0) || (strcmp(input,"-timepoints") == 0) || (strcmp(input,"-repetitions") == 0) )
+        {
+			if ( (i+1) >= argc  )
+			{
+			    printf("Unable to read value after %s !\n",input);
+                return EXIT_FAILURE;
+			}
+
+            long value = strtol(argv[i+1], &p, 10);
+
+			if (!isspace(*p) && *p != 0)
+		    {
+		        printf("%s must be an integer! You provided %s \n",input,argv[i+1]);
+				return EXIT_FAILURE;
+		    }
+            else if (value <= 0)
+            {
+                printf("Invalid value for %s ! You provided %s \n",input,argv[i+1]);
+                return EXIT_FAILURE;
+            }
+
+			if (strcmp(input,"-width") == 0)
+				DATA_W = (int)value;
+			else if (strcmp(input,"-height") == 0)
+				DATA_H = (int)value;
+			else if (strcmp(input,"-depth") == 0)
+				DATA_D = (int)value;
+			else if (strcmp(input,"-timepoints") == 0)
+				DATA_T = (int)value;
+			else if (strcmp(input,"-repetitions") == 0)
+				REPETITIONS = (int)value;
+            i += 2;
+        }
+        else
+        {
+            printf("Unrecognized option! %s \n",argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+	size_t N = (size_t)DATA_W * (size_t)DATA_H * (size_t)DATA_D * (size_t)DATA_T;
+
+	float* h_Volumes = (float*)malloc(N * sizeof(float));
+	float* h_Original_Volumes = (float*)malloc(N * sizeof(float));
+	float* h_Reference_Volumes = (float*)malloc(N * sizeof(float));
+	if ( (h_Volumes == NULL) || (h_Original_Volumes == NULL) || (h_Reference_Volumes == NULL) )
+	{
+		printf("Could not allocate host memory!\n");
+		free(h_Volumes);
+		free(h_Original_Volumes);
+		free(h_Reference_Volumes);
+		return EXIT_FAILURE;
+	}
+
+	for (size_t v = 0; v < N; v++)
+	{
+		h_Original_Volumes[v] = (float)(v % 16777216);
+	}
+
+	// Host functions only, OpenCL is not initiated
+	BROCCOLI_LIB BROCCOLI;
+
+	const char* conversionNames[4] = {"XYZT to XYTZ", "XYTZ to XYZT", "XYZT to TXYZ", "TXYZ to XYZT"};
+
+	printf("Dataset %i x %i x %i x %i, %.1f MB, best of %i runs \n\n",DATA_W,DATA_H,DATA_D,DATA_T,(double)(N * sizeof(float)) / 1024.0 / 1024.0,REPETITIONS);
+	printf("%-16s %14s %14s %10s %14s %14s %8s\n","Conversion","Original (s)","In place (s)","Speedup","Original MB","In place MB","Equal");
+
+	for (int conversion = 0; conversion < 4; conversion++)
+	{
+		// The inverse conversions start from the output of the forward conversion
+		memcpy(h_Reference_Volumes, h_Original_Volumes, N * sizeof(float));
+		if (conversion == 1)
+		{
+			BROCCOLI.FlipVolumesXYZTtoXYTZ(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+		}
+		else if (conversion == 3)
+		{
+			FlipVolumesXYZTtoTXYZ(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+		}
+		memcpy(h_Volumes, h_Reference_Volumes, N * sizeof(float));
+
+		std::vector<double> originalTimes, inPlaceTimes;
+
+		for (int r = 0; r < REPETITIONS; r++)
+		{
+			memcpy(h_Reference_Volumes, h_Volumes, N * sizeof(float));
+			double startTime = GetWallTime();
+			if (conversion == 0)
+				BROCCOLI.FlipVolumesXYZTtoXYTZ(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else if (conversion == 1)
+				BROCCOLI.FlipVolumesXYTZtoXYZT(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else if (conversion == 2)
+				FlipVolumesXYZTtoTXYZ(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else
+				FlipVolumesTXYZtoXYZT(h_Reference_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			originalTimes.push_back(GetWallTime() - startTime);
+		}
+
+		float* h_Input_Volumes = (float*)malloc(N * sizeof(float));
+		if (h_Input_Volumes == NULL)
+		{
+			printf("Could not allocate host memory!\n");
+			break;
+		}
+		memcpy(h_Input_Volumes, h_Volumes, N * sizeof(float));
+
+		for (int r = 0; r < REPETITIONS; r++)
+		{
+			memcpy(h_Volumes, h_Input_Volumes, N * sizeof(float));
+			double startTime = GetWallTime();
+			if (conversion == 0)
+				BROCCOLI.ConvertLayoutXYZTtoXYTZ(h_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else if (conversion == 1)
+				BROCCOLI.ConvertLayoutXYTZtoXYZT(h_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else if (conversion == 2)
+				BROCCOLI.ConvertLayoutXYZTtoTXYZ(h_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			else
+				BROCCOLI.ConvertLayoutTXYZtoXYZT(h_Volumes, DATA_W, DATA_H, DATA_D, DATA_T);
+			inPlaceTimes.push_back(GetWallTime() - startTime);
+		}
+		free(h_Input_Volumes);
+
+		bool equal = (memcmp(h_Volumes, h_Reference_Volumes, N * sizeof(float)) == 0);
+
+		// Extra host memory, a full copy for the original versions, one slice of time series or one chunk per thread for the new ones
+		double originalMB = (double)(N * sizeof(float)) / 1024.0 / 1024.0;
+		double inPlaceMB;
+		if (conversion >= 2)
+			inPlaceMB = (double)((size_t)DATA_W * DATA_H * DATA_T * sizeof(float)) / 1024.0 / 1024.0;
+		else
+			inPlaceMB = (double)(LAYOUT_CHUNK_SIZE * sizeof(float)) / 1024.0 / 1024.0;
+
+		double originalTime = *std::min_element(originalTimes.begin(), originalTimes.end());
+		double inPlaceTime = *std::min_element(inPlaceTimes.begin(), inPlaceTimes.end());
+
+		printf("%-16s %14.4f %14.4f %10.2f %14.2f %14.2f %8s\n",conversionNames[conversion],originalTime,inPlaceTime,originalTime / inPlaceTime,originalMB,inPlaceMB,equal ? "yes" : "NO");
+	}
+
+	free(h_Volumes);
+	free(h_Original_Volumes);
+	free(h_Reference_Volumes);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#!/bin/bash
+
+BROCCOLI_GIT_DIRECTORY=`git rev-parse --show-toplevel`
+
+# Set OpenCL package to use
+AMD=0
+INTEL=1
+NVIDIA=2
+#OPENCL_PACKAGE=$AMD
+OPENCL_PACKAGE=$INTEL
+#OPENCL_PACKAGE=$NVIDIA
+
+# Set compilation mode to use
+RELEASE=0
+DEBUG=1
+COMPILATION=$RELEASE
+
+# Need to install AMD OpenCL SDK first
+if [ "$OPENCL_PACKAGE" -eq "$AMD" ]; then
+    OPENCL_HEADER_DIRECTORY1=/opt/AMDAPP/include 
+    OPENCL_HEADER_DIRECTORY2=/opt/AMDAPP/include/CL 
+    OPENCL_LIBRARY_DIRECTORY=/opt/AMDAPP/lib/x86_64 
+# Need to install Intel OpenCL SDK and Intel OpenCL runtime first
+elif [ "$OPENCL_PACKAGE" -eq "$INTEL" ]; then
+    OPENCL_HEADER_DIRECTORY1=/opt/intel/opencl-sdk/include 
+    OPENCL_HEADER_DIRECTORY2=/opt/intel/opencl-sdk/include/CL
+    OPENCL_LIBRARY_DIRECTORY=/opt/intel/opencl/lib64
+# Need to install Nvidia CUDA SDK first
+elif [ "$OPENCL_PACKAGE" -eq "$NVIDIA" ]; then
+    OPENCL_HEADER_DIRECTORY1=/usr/local/cuda-6.5/include/CL
+    OPENCL_HEADER_DIRECTORY2=
+    #OPENCL_LIBRARY_DIRECTORY=/usr/lib64
+	OPENCL_LIBRARY_DIRECTORY=/usr/local/cuda-6.5/lib64
+else
+    echo "Unknown OpenCL package!"
+fi
+
+CLBLAS_LIBRARY_DIRECTORY=${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/clBLASLinux
+
+# Set compilation flags
+if [ "$COMPILATION" -eq "$RELEASE" ] ; then
+    FLAGS="-O3 -DNDEBUG -m64 -fopenmp"
+	BROCCOLI_LIBRARY_DIRECTORY=${BROCCOLI_GIT_DIRECTORY}/compiled/BROCCOLI_LIB/Linux/Release
+elif [ "$COMPILATION" -eq "$DEBUG" ] ; then
+    FLAGS="-O0 -g -m64"
+	BROCCOLI_LIBRARY_DIRECTORY=${BROCCOLI_GIT_DIRECTORY}/compiled/BROCCOLI_LIB/Linux/Debug
+else
+    echo "Unknown compilation mode"
+fi
+
+
+g++ Benchmark.cpp -I${OPENCL_HEADER_DIRECTORY1} -I${OPENCL_HEADER_DIRECTORY2} -L${OPENCL_LIBRARY_DIRECTORY} -L${CLBLAS_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/ -L${BROCCOLI_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/Eigen -lBROCCOLI_LIB -lOpenCL -lclBLAS ${FLAGS} -o Benchmark
+
+# Host only, compares the storage order conversions of 4D datasets
+g++ LayoutBenchmark.cpp -I${OPENCL_HEADER_DIRECTORY1} -I${OPENCL_HEADER_DIRECTORY2} -L${OPENCL_LIBRARY_DIRECTORY} -L${CLBLAS_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/ -L${BROCCOLI_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/Eigen -lBROCCOLI_LIB -lOpenCL -lclBLAS ${FLAGS} -o LayoutBenchmark
+
+# Compares the interpolation modes for linear transformations, accuracy and throughput
+g++ InterpolationBenchmark.cpp -I${OPENCL_HEADER_DIRECTORY1} -I${OPENCL_HEADER_DIRECTORY2} -L${OPENCL_LIBRARY_DIRECTORY} -L${CLBLAS_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/ -L${BROCCOLI_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/Eigen -lBROCCOLI_LIB -lOpenCL -lclBLAS ${FLAGS} -o InterpolationBenchmark
+
+# Host only, accuracy of storing the whitened and permuted volumes of the first level permutation test, and the original data of the first level GLM, as half floats
+g++ HalfPrecisionBenchmark.cpp -I${OPENCL_HEADER_DIRECTORY1} -I${OPENCL_HEADER_DIRECTORY2} -L${OPENCL_LIBRARY_DIRECTORY} -L${CLBLAS_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/ -L${BROCCOLI_LIBRARY_DIRECTORY} -I${BROCCOLI_GIT_DIRECTORY}/code/BROCCOLI_LIB/Eigen -lBROCCOLI_LIB -lOpenCL -lclBLAS ${FLAGS} -o HalfPrecisionBenchmark
+
+# Example, results are appended to benchmarks.txt to compare releases
+# ./Benchmark -platform 0 -device 0 -output benchmarks.txt -trace trace
+# ./LayoutBenchmark -timepoints 400
+# ./InterpolationBenchmark -platform 0 -device 0 -degrees 10
+# ./HalfPrecisionBenchmark -voxels 20000 -permutations 50
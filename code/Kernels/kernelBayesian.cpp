@@ -575,3 +575,1021 @@ __kernel void CalculateStatisticalMapsGLMBayesian(__global float* Statistical_Ma
 }
 
 
+
+// Bayesian GLM for any number of regressors, with an AR(1) noise model
+
+// Same values as in broccoli_constants.h
+#define MAX_BAYESIAN_REGRESSORS 16
+#define MAX_BAYESIAN_PACKED_SIZE 136
+#define MAX_BAYESIAN_NUISANCE_REGRESSORS 32
+#define MAX_BAYESIAN_CONTRASTS 32
+
+#define PHILOX_M0 0xD2511F53
+#define PHILOX_M1 0xCD9E8D57
+#define PHILOX_W0 0x9E3779B9
+#define PHILOX_W1 0xBB67AE85
+
+// Philox4x32-10 counter based random number generator (Salmon et al., 2011)
+// Every output is a function of the counter and the key only, so no state needs to be kept in global memory
+void Philox4x32(__private uint* output,
+                uint c0,
+                uint c1,
+                uint c2,
+                uint c3,
+                uint k0,
+                uint k1)
+{
+	for (int round = 0; round < 10; round++)
+	{
+		uint hi0 = mul_hi((uint)PHILOX_M0, c0);
+		uint lo0 = (uint)PHILOX_M0 * c0;
+		uint hi1 = mul_hi((uint)PHILOX_M1, c2);
+		uint lo1 = (uint)PHILOX_M1 * c2;
+
+		c0 = hi1 ^ c1 ^ k0;
+		c1 = lo1;
+		c2 = hi0 ^ c3 ^ k1;
+		c3 = lo0;
+
+		k0 += (uint)PHILOX_W0;
+		k1 += (uint)PHILOX_W1;
+	}
+
+	output[0] = c0;
+	output[1] = c1;
+	output[2] = c2;
+	output[3] = c3;
+}
+
+// One random stream per voxel, the key is given by the voxel index and the seed
+typedef struct
+{
+	uint counter;
+	uint key0;
+	uint key1;
+	uint random[4];
+	int available;
+	float spare_normal;
+	int has_spare_normal;
+} PhiloxStream;
+
+void InitPhiloxStream(__private PhiloxStream* stream,
+                      uint voxel,
+                      uint seed)
+{
+	stream->counter = 0;
+	stream->key0 = voxel;
+	stream->key1 = seed;
+	stream->available = 0;
+	stream->spare_normal = 0.0f;
+	stream->has_spare_normal = 0;
+}
+
+// Uniform number in (0,1], four numbers are generated per call of Philox4x32
+float PhiloxUniform(__private PhiloxStream* stream)
+{
+	if (stream->available == 0)
+	{
+		Philox4x32(stream->random, stream->counter, 0, 0, 0, stream->key0, stream->key1);
+		stream->counter++;
+		stream->available = 4;
+	}
+
+	stream->available--;
+	return ((float)(stream->random[stream->available] >> 8) + 1.0f) * (1.0f / 16777216.0f);
+}
+
+// Normal number by the Box-Muller transform, the second number of each transform is saved for the next call
+float PhiloxNormal(__private PhiloxStream* stream)
+{
+	if (stream->has_spare_normal)
+	{
+		stream->has_spare_normal = 0;
+		return stream->spare_normal;
+	}
+
+	float radius = sqrt(-2.0f * log(PhiloxUniform(stream)));
+	float angle = 2.0f * (float)pi * PhiloxUniform(stream);
+
+	stream->spare_normal = radius * sin(angle);
+	stream->has_spare_normal = 1;
+
+	return radius * cos(angle);
+}
+
+// Gamma(a,1) number for a >= 1, using the method by Marsaglia and Tsang (2000)
+float PhiloxGamma(float a,
+                  __private PhiloxStream* stream)
+{
+	float d = a - 1.0f/3.0f;
+	float c = 1.0f / sqrt(9.0f * d);
+
+	// The acceptance rate is above 95%, the loop is bounded to avoid hanging on NaNs
+	for (int attempt = 0; attempt < 100; attempt++)
+	{
+		float x = PhiloxNormal(stream);
+		float v = 1.0f + c * x;
+		if (v <= 0.0f)
+		{
+			continue;
+		}
+
+		v = v * v * v;
+		float u = PhiloxUniform(stream);
+		if (log(u) < (0.5f * x * x + d - d * v + d * log(v)))
+		{
+			return d * v;
+		}
+	}
+
+	return d;
+}
+
+// Index of element (i,j), i >= j, in a lower triangle stored row by row
+int PackedIndexBayesian(int i, int j)
+{
+	return i * (i + 1) / 2 + j;
+}
+
+// In place Cholesky factorization A = L L^T of a packed lower triangle, returns 0 if the matrix is not positive definite
+int CholeskyFactorizeBayesian(__private float* A,
+                              int N)
+{
+	for (int j = 0; j < N; j++)
+	{
+		float diagonal = A[PackedIndexBayesian(j,j)];
+		for (int k = 0; k < j; k++)
+		{
+			diagonal -= A[PackedIndexBayesian(j,k)] * A[PackedIndexBayesian(j,k)];
+		}
+
+		if (diagonal <= 0.0f)
+		{
+			return 0;
+		}
+
+		diagonal = sqrt(diagonal);
+		A[PackedIndexBayesian(j,j)] = diagonal;
+
+		for (int i = j + 1; i < N; i++)
+		{
+			float value = A[PackedIndexBayesian(i,j)];
+			for (int k = 0; k < j; k++)
+			{
+				value -= A[PackedIndexBayesian(i,k)] * A[PackedIndexBayesian(j,k)];
+			}
+			A[PackedIndexBayesian(i,j)] = value / diagonal;
+		}
+	}
+
+	return 1;
+}
+
+// Solves L x = b, b is overwritten with x
+void ForwardSubstitutionBayesian(__private const float* L,
+                                 __private float* b,
+                                 int N)
+{
+	for (int i = 0; i < N; i++)
+	{
+		float value = b[i];
+		for (int k = 0; k < i; k++)
+		{
+			value -= L[PackedIndexBayesian(i,k)] * b[k];
+		}
+		b[i] = value / L[PackedIndexBayesian(i,i)];
+	}
+}
+
+// Solves L^T x = b, b is overwritten with x
+void BackSubstitutionBayesian(__private const float* L,
+                              __private float* b,
+                              int N)
+{
+	for (int i = N - 1; i >= 0; i--)
+	{
+		float value = b[i];
+		for (int k = i + 1; k < N; k++)
+		{
+			value -= L[PackedIndexBayesian(k,i)] * b[k];
+		}
+		b[i] = value / L[PackedIndexBayesian(i,i)];
+	}
+}
+
+// Gibbs sampling of beta, sigma^2 and rho for one voxel. The time series is read with a stride between the time points,
+// so that the same function can be used for volumes and for lists of brain voxels. The nuisance regressors (detrending, motion)
+// are first removed, the sampler then only uses lag 0 and lag 1 sums of the time series, which are calculated once
+void GibbsSamplerGLMAR1(__global float* Statistical_Maps,
+                        __global float* Beta_Volumes,
+                        __global float* AR_Estimates,
+                        __global const float* Volumes,
+                        int voxel,
+                        int volume_stride,
+                        int output_voxel,
+                        int output_stride,
+                        __constant float* c_X_GLM,
+                        __constant float* c_X_Nuisance,
+                        __constant float* c_xtxxt_Nuisance,
+                        __constant float* c_Contrasts,
+                        __constant float* c_InvOmega0,
+                        __constant float* c_S00,
+                        __constant float* c_S01,
+                        __constant float* c_S11,
+                        int NUMBER_OF_VOLUMES,
+                        int NUMBER_OF_REGRESSORS,
+                        int NUMBER_OF_NUISANCE_REGRESSORS,
+                        int NUMBER_OF_CONTRASTS,
+                        int NUMBER_OF_ITERATIONS,
+                        uint seed)
+{
+	// Prior options
+	float r = 0.5f;                    // Prior mean on rho1
+	float c = 0.3f;                    // Prior standard deviation on first lag.
+	float a0 = 0.01f;                  // First parameter in IG prior for sigma^2
+	float b0 = 0.01f;                  // Second parameter in IG prior for sigma^2
+
+	float InvA0 = 1.0f / (c * c);
+
+	// Algorithmic options
+	float prcBurnin = 10.0f;             // Percentage of nIter used for burnin. Note: effective number of iter is nIter.
+
+	int nBurnin = (int)round((float)NUMBER_OF_ITERATIONS*(prcBurnin/100.0f));
+
+	// Estimate the nuisance beta weights
+	float nuisance_beta[MAX_BAYESIAN_NUISANCE_REGRESSORS];
+	for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+	{
+		nuisance_beta[n] = 0.0f;
+	}
+
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[voxel + v * volume_stride];
+		for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+		{
+			nuisance_beta[n] += value * c_xtxxt_Nuisance[NUMBER_OF_VOLUMES * n + v];
+		}
+	}
+
+	// Sums of the regressed time series and the regressors, for lag 0 and lag 1
+	float m00[MAX_BAYESIAN_REGRESSORS];
+	float m01[MAX_BAYESIAN_REGRESSORS];
+	float m10[MAX_BAYESIAN_REGRESSORS];
+	float m11[MAX_BAYESIAN_REGRESSORS];
+
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		m00[i] = 0.0f;
+		m01[i] = 0.0f;
+		m10[i] = 0.0f;
+		m11[i] = 0.0f;
+	}
+
+	float g00 = 0.0f;
+	float g01 = 0.0f;
+	float g11 = 0.0f;
+
+	float old_value = 0.0f;
+
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[voxel + v * volume_stride];
+		for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+		{
+			value -= nuisance_beta[n] * c_X_Nuisance[NUMBER_OF_VOLUMES * n + v];
+		}
+
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			m00[i] += c_X_GLM[NUMBER_OF_VOLUMES * i + v] * value;
+		}
+		g00 += value * value;
+
+		if (v > 0)
+		{
+			for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+			{
+				m01[i] += c_X_GLM[NUMBER_OF_VOLUMES * i + v] * old_value;
+				m10[i] += c_X_GLM[NUMBER_OF_VOLUMES * i + (v - 1)] * value;
+				m11[i] += c_X_GLM[NUMBER_OF_VOLUMES * i + (v - 1)] * old_value;
+			}
+			g01 += value * old_value;
+			g11 += old_value * old_value;
+		}
+
+		old_value = value;
+	}
+
+	float L[MAX_BAYESIAN_PACKED_SIZE];
+	float XtildeYtilde[MAX_BAYESIAN_REGRESSORS];
+	float betaT[MAX_BAYESIAN_REGRESSORS];
+	float beta[MAX_BAYESIAN_REGRESSORS];
+	float beta_sum[MAX_BAYESIAN_REGRESSORS];
+	int probability[MAX_BAYESIAN_CONTRASTS];
+
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		beta_sum[i] = 0.0f;
+	}
+
+	for (int k = 0; k < NUMBER_OF_CONTRASTS; k++)
+	{
+		probability[k] = 0;
+	}
+
+	PhiloxStream stream;
+	InitPhiloxStream(&stream, (uint)output_voxel, seed);
+
+	float aT = a0 + (float)NUMBER_OF_VOLUMES/2.0f;
+	float rho = 0.0f;
+	float rho_sum = 0.0f;
+
+	// Number of samples after the burnin, less than NUMBER_OF_ITERATIONS if a factorization fails
+	int samples = 0;
+
+	// Loop over iterations
+	for (int it = 0; it < (nBurnin + NUMBER_OF_ITERATIONS); it++)
+	{
+		// Prewhitening of regressors and data, for the current rho
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			for (int j = 0; j <= i; j++)
+			{
+				L[PackedIndexBayesian(i,j)] = c_InvOmega0[i + j * NUMBER_OF_REGRESSORS] + c_S00[i + j * NUMBER_OF_REGRESSORS] - rho * (c_S01[i + j * NUMBER_OF_REGRESSORS] + c_S01[j + i * NUMBER_OF_REGRESSORS]) + rho * rho * c_S11[i + j * NUMBER_OF_REGRESSORS];
+			}
+			XtildeYtilde[i] = m00[i] - rho * (m01[i] + m10[i]) + rho * rho * m11[i];
+		}
+		float Ytildesquared = g00 - 2.0f * rho * g01 + rho * rho * g11;
+
+		// The posterior precision InvOmegaT = L L^T is used directly, no inverse is calculated
+		if (!CholeskyFactorizeBayesian(L, NUMBER_OF_REGRESSORS))
+		{
+			break;
+		}
+
+		// Posterior mean betaT = OmegaT * XtildeYtilde
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			betaT[i] = XtildeYtilde[i];
+		}
+		ForwardSubstitutionBayesian(L, betaT, NUMBER_OF_REGRESSORS);
+		BackSubstitutionBayesian(L, betaT, NUMBER_OF_REGRESSORS);
+
+		float bT = Ytildesquared;
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			bT -= betaT[i] * XtildeYtilde[i];
+		}
+		bT = b0 + 0.5f * max(bT, 0.0f);
+
+		// Block 1 - Step 1a. Update sigma2
+		float sigma2 = bT / PhiloxGamma(aT, &stream);
+
+		// Block 1 - Step 1b. Update beta | sigma2, beta = betaT + sqrt(sigma2) L^-T z has covariance sigma2 * OmegaT
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			beta[i] = PhiloxNormal(&stream);
+		}
+		BackSubstitutionBayesian(L, beta, NUMBER_OF_REGRESSORS);
+		float sigma = sqrt(sigma2);
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			beta[i] = betaT[i] + sigma * beta[i];
+		}
+
+		// Block 2, update rho, residual sums from the lag 0 and lag 1 sums
+		float zsquared = g11;
+		float zu = g01;
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			zsquared -= 2.0f * beta[i] * m11[i];
+			zu -= beta[i] * (m01[i] + m10[i]);
+			for (int j = 0; j < NUMBER_OF_REGRESSORS; j++)
+			{
+				zsquared += beta[i] * c_S11[i + j * NUMBER_OF_REGRESSORS] * beta[j];
+				zu += beta[i] * c_S01[i + j * NUMBER_OF_REGRESSORS] * beta[j];
+			}
+		}
+
+		// Generate rho
+		float InvAT = InvA0 + zsquared / sigma2;
+		float AT = 1.0f / InvAT;
+		float rhoT = AT * (InvA0 * r + zu / sigma2);
+		float rhoProp = rhoT + sqrt(AT) * PhiloxNormal(&stream);
+
+		if (myabs(rhoProp) < 1.0f)
+		{
+			rho = rhoProp;
+		}
+
+		if (it >= nBurnin)
+		{
+			for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+			{
+				beta_sum[i] += beta[i];
+			}
+
+			// Posterior probability of a positive contrast
+			for (int k = 0; k < NUMBER_OF_CONTRASTS; k++)
+			{
+				float contrast_value = 0.0f;
+				for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+				{
+					contrast_value += c_Contrasts[NUMBER_OF_REGRESSORS * k + i] * beta[i];
+				}
+
+				if (contrast_value > 0.0f)
+				{
+					probability[k]++;
+				}
+			}
+
+			rho_sum += rho;
+			samples++;
+		}
+	}
+
+	// The voxel is invalid if the factorization failed before the first sample
+	int valid = (samples > 0);
+
+	for (int k = 0; k < NUMBER_OF_CONTRASTS; k++)
+	{
+		Statistical_Maps[output_voxel + k * output_stride] = valid ? (float)probability[k]/(float)samples : 0.0f;
+	}
+
+	// Posterior means
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		Beta_Volumes[output_voxel + i * output_stride] = valid ? beta_sum[i]/(float)samples : 0.0f;
+	}
+
+	AR_Estimates[output_voxel] = valid ? rho_sum/(float)samples : 0.0f;
+}
+
+// Generates posterior probability maps (PPMs) for all contrasts, one work item per voxel of the volume
+
+__kernel void CalculateStatisticalMapsGLMBayesianVolume(__global float* Statistical_Maps,
+                                                        __global float* Beta_Volumes,
+                                                        __global float* AR_Estimates,
+                                                        __global const float* Volumes,
+                                                        __global const float* Mask,
+                                                        __constant float* c_X_GLM,
+                                                        __constant float* c_X_Nuisance,
+                                                        __constant float* c_xtxxt_Nuisance,
+                                                        __constant float* c_Contrasts,
+                                                        __constant float* c_InvOmega0,
+                                                        __constant float* c_S00,
+                                                        __constant float* c_S01,
+                                                        __constant float* c_S11,
+                                                        __private int DATA_W,
+                                                        __private int DATA_H,
+                                                        __private int DATA_D,
+                                                        __private int NUMBER_OF_VOLUMES,
+                                                        __private int NUMBER_OF_REGRESSORS,
+                                                        __private int NUMBER_OF_NUISANCE_REGRESSORS,
+                                                        __private int NUMBER_OF_CONTRASTS,
+                                                        __private int NUMBER_OF_ITERATIONS,
+                                                        __private uint seed)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int voxel = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+	int VOLUME_SIZE = DATA_W * DATA_H * DATA_D;
+
+	if ( Mask[voxel] != 1.0f )
+	{
+		for (int k = 0; k < NUMBER_OF_CONTRASTS; k++)
+		{
+			Statistical_Maps[voxel + k * VOLUME_SIZE] = 0.0f;
+		}
+
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			Beta_Volumes[voxel + i * VOLUME_SIZE] = 0.0f;
+		}
+
+		AR_Estimates[voxel] = 0.0f;
+
+		return;
+	}
+
+	GibbsSamplerGLMAR1(Statistical_Maps, Beta_Volumes, AR_Estimates, Volumes, voxel, VOLUME_SIZE, voxel, VOLUME_SIZE, c_X_GLM, c_X_Nuisance, c_xtxxt_Nuisance, c_Contrasts, c_InvOmega0, c_S00, c_S01, c_S11, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS, NUMBER_OF_NUISANCE_REGRESSORS, NUMBER_OF_CONTRASTS, NUMBER_OF_ITERATIONS, seed);
+}
+
+// Generates posterior probability maps (PPMs) for all contrasts, one work item per brain voxel
+// The time series are stored as v + t * NUMBER_OF_VOXELS, the results are written to the voxels given by Voxel_Indices
+
+__kernel void CalculateStatisticalMapsGLMBayesianVoxelList(__global float* Statistical_Maps,
+                                                           __global float* Beta_Volumes,
+                                                           __global float* AR_Estimates,
+                                                           __global const float* Volumes,
+                                                           __global const int* Voxel_Indices,
+                                                           __constant float* c_X_GLM,
+                                                           __constant float* c_X_Nuisance,
+                                                           __constant float* c_xtxxt_Nuisance,
+                                                           __constant float* c_Contrasts,
+                                                           __constant float* c_InvOmega0,
+                                                           __constant float* c_S00,
+                                                           __constant float* c_S01,
+                                                           __constant float* c_S11,
+                                                           __private int NUMBER_OF_VOXELS,
+                                                           __private int VOLUME_SIZE,
+                                                           __private int NUMBER_OF_VOLUMES,
+                                                           __private int NUMBER_OF_REGRESSORS,
+                                                           __private int NUMBER_OF_NUISANCE_REGRESSORS,
+                                                           __private int NUMBER_OF_CONTRASTS,
+                                                           __private int NUMBER_OF_ITERATIONS,
+                                                           __private uint seed)
+{
+	int v = get_global_id(0);
+
+	if (v >= NUMBER_OF_VOXELS)
+		return;
+
+	GibbsSamplerGLMAR1(Statistical_Maps, Beta_Volumes, AR_Estimates, Volumes, v, NUMBER_OF_VOXELS, Voxel_Indices[v], VOLUME_SIZE, c_X_GLM, c_X_Nuisance, c_xtxxt_Nuisance, c_Contrasts, c_InvOmega0, c_S00, c_S01, c_S11, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS, NUMBER_OF_NUISANCE_REGRESSORS, NUMBER_OF_CONTRASTS, NUMBER_OF_ITERATIONS, seed);
+}
+
+
+
+// Variational Bayes GLM with an AR(p) noise model (Penny, Kiebel & Friston, 2003)
+
+// Same value as in broccoli_constants.h
+#define MAX_VB_AR_ORDER 4
+#define MAX_VB_LAG_PRODUCTS 25
+
+// Digamma function, recurrence to x >= 6 followed by the asymptotic series
+float DigammaVB(float x)
+{
+	float result = 0.0f;
+	while (x < 6.0f)
+	{
+		result -= 1.0f / x;
+		x += 1.0f;
+	}
+
+	float f = 1.0f / (x * x);
+	return result + log(x) - 0.5f / x - f * (1.0f/12.0f - f * (1.0f/120.0f - f * (1.0f/252.0f - f * (1.0f/240.0f - f * (1.0f/132.0f)))));
+}
+
+// KL divergence between the Gamma distributions Ga(shape,rate) and Ga(shape0,rate0)
+float KLGammaVB(float shape,
+                float rate,
+                float shape0,
+                float rate0)
+{
+	return (shape - shape0) * DigammaVB(shape) - lgamma(shape) + lgamma(shape0) + shape0 * (log(rate) - log(rate0)) + shape * (rate0 - rate) / rate;
+}
+
+// Posterior covariance and log determinant from the Cholesky factor L of the posterior precision, Sigma = L^-T L^-1
+float InverseFromCholeskyVB(__private const float* L,
+                            __private float* Sigma,
+                            __private float* temp,
+                            int N)
+{
+	float logDeterminant = 0.0f;
+	for (int i = 0; i < N; i++)
+	{
+		logDeterminant -= 2.0f * log(L[PackedIndexBayesian(i,i)]);
+	}
+
+	for (int j = 0; j < N; j++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			temp[i] = (i == j) ? 1.0f : 0.0f;
+		}
+		ForwardSubstitutionBayesian(L, temp, N);
+		BackSubstitutionBayesian(L, temp, N);
+		for (int i = 0; i < N; i++)
+		{
+			Sigma[i + j * N] = temp[i];
+		}
+	}
+
+	return logDeterminant;
+}
+
+// Variational Bayes for one voxel, with factorized posteriors q(beta) q(a) q(lambda) q(alpha) q(gamma) for the beta weights, the AR
+// parameters, the noise precision and the prior precisions of the beta weights and the AR parameters. The nuisance regressors are
+// first removed, all updates are then calculated from lagged products of the time series and the regressors, which are calculated once.
+// The lagged products of the regressors, c_SXX, are the same for all voxels. The closed form updates are iterated until the relative
+// change of the negative free energy (the ELBO) is smaller than the tolerance
+void VariationalBayesGLMARp(__global float* Statistical_Maps,
+                            __global float* Beta_Volumes,
+                            __global float* AR1_Estimates,
+                            __global float* AR2_Estimates,
+                            __global float* AR3_Estimates,
+                            __global float* AR4_Estimates,
+                            __global const float* Volumes,
+                            int voxel,
+                            int volume_stride,
+                            int output_voxel,
+                            int output_stride,
+                            __constant float* c_X_GLM,
+                            __constant float* c_X_Nuisance,
+                            __constant float* c_xtxxt_Nuisance,
+                            __constant float* c_Contrasts,
+                            __constant float* c_SXX,
+                            int NUMBER_OF_VOLUMES,
+                            int NUMBER_OF_REGRESSORS,
+                            int NUMBER_OF_NUISANCE_REGRESSORS,
+                            int NUMBER_OF_CONTRASTS,
+                            int AR_ORDER,
+                            int MAX_ITERATIONS,
+                            float TOLERANCE)
+{
+	// Vague Gamma priors, shape and rate, for all precisions
+	float shape0 = 0.001f;
+	float rate0 = 0.001f;
+
+	int K = NUMBER_OF_REGRESSORS;
+	int P = AR_ORDER;
+	int LAGS = P + 1;
+
+	// Estimate the nuisance beta weights
+	float nuisance_beta[MAX_BAYESIAN_NUISANCE_REGRESSORS];
+	for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+	{
+		nuisance_beta[n] = 0.0f;
+	}
+
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[voxel + v * volume_stride];
+		for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+		{
+			nuisance_beta[n] += value * c_xtxxt_Nuisance[NUMBER_OF_VOLUMES * n + v];
+		}
+	}
+
+	// Lagged products Syy(i,j) = sum_t y(t-i) y(t-j) and SXy(i,j) = sum_t x(t-i) y(t-j), for t = P ... T-1
+	float Syy[MAX_VB_LAG_PRODUCTS];
+	float SXy[MAX_VB_LAG_PRODUCTS * MAX_BAYESIAN_REGRESSORS];
+	float y[MAX_VB_AR_ORDER + 1];
+
+	for (int l = 0; l < LAGS * LAGS; l++)
+	{
+		Syy[l] = 0.0f;
+		for (int k = 0; k < K; k++)
+		{
+			SXy[l * K + k] = 0.0f;
+		}
+	}
+
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[voxel + v * volume_stride];
+		for (int n = 0; n < NUMBER_OF_NUISANCE_REGRESSORS; n++)
+		{
+			value -= nuisance_beta[n] * c_X_Nuisance[NUMBER_OF_VOLUMES * n + v];
+		}
+
+		// y[i] is the time series at time point v - i
+		for (int i = P; i > 0; i--)
+		{
+			y[i] = y[i-1];
+		}
+		y[0] = value;
+
+		if (v < P)
+		{
+			continue;
+		}
+
+		for (int j = 0; j < LAGS; j++)
+		{
+			for (int i = 0; i < LAGS; i++)
+			{
+				Syy[i + j * LAGS] += y[i] * y[j];
+				for (int k = 0; k < K; k++)
+				{
+					SXy[(i + j * LAGS) * K + k] += c_X_GLM[NUMBER_OF_VOLUMES * k + (v - i)] * y[j];
+				}
+			}
+		}
+	}
+
+	float N = (float)(NUMBER_OF_VOLUMES - P);
+
+	// Posterior of the beta weights, the new mean is solved in beta_update and only kept if the factorization succeeds
+	float beta_mean[MAX_BAYESIAN_REGRESSORS];
+	float beta_update[MAX_BAYESIAN_REGRESSORS];
+	float beta_covariance[MAX_BAYESIAN_REGRESSORS * MAX_BAYESIAN_REGRESSORS];
+	float L[MAX_BAYESIAN_PACKED_SIZE];
+	float temp[MAX_BAYESIAN_REGRESSORS];
+
+	// Posterior of the AR parameters, same for ar_update
+	float ar_mean[MAX_VB_AR_ORDER];
+	float ar_update[MAX_VB_AR_ORDER];
+	float ar_covariance[MAX_VB_AR_ORDER * MAX_VB_AR_ORDER];
+
+	// Second moment of the filter u = [1, -a], E[u u^T], and expected lagged products of the residuals
+	float U[MAX_VB_LAG_PRODUCTS];
+	float Rxx[MAX_VB_LAG_PRODUCTS];
+
+	for (int i = 0; i < P; i++)
+	{
+		ar_mean[i] = 0.0f;
+		for (int j = 0; j < P; j++)
+		{
+			ar_covariance[i + j * P] = 0.0f;
+		}
+	}
+
+	float lambda = N / max(Syy[0], 1e-10f);
+	float alpha = 1.0f;
+	float gamma = 1.0f;
+
+	float F_old = 0.0f;
+	int valid = 0;
+
+	for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++)
+	{
+		for (int j = 0; j < LAGS; j++)
+		{
+			for (int i = 0; i < LAGS; i++)
+			{
+				float ui = (i == 0) ? 1.0f : -ar_mean[i-1];
+				float uj = (j == 0) ? 1.0f : -ar_mean[j-1];
+				float covariance = ((i > 0) && (j > 0)) ? ar_covariance[(i-1) + (j-1) * P] : 0.0f;
+				U[i + j * LAGS] = ui * uj + covariance;
+			}
+		}
+
+		// Update q(beta), precision lambda E[Xtilde^T Xtilde] + alpha I, mean from lambda E[Xtilde^T ytilde]
+		for (int a = 0; a < K; a++)
+		{
+			for (int b = 0; b <= a; b++)
+			{
+				float value = 0.0f;
+				for (int l = 0; l < LAGS * LAGS; l++)
+				{
+					value += U[l] * c_SXX[l * K * K + a + b * K];
+				}
+				L[PackedIndexBayesian(a,b)] = lambda * value + ((a == b) ? alpha : 0.0f);
+			}
+
+			float value = 0.0f;
+			for (int l = 0; l < LAGS * LAGS; l++)
+			{
+				value += U[l] * SXy[l * K + a];
+			}
+			beta_update[a] = lambda * value;
+		}
+
+		// Keep the previous iterate if the precision matrix is not positive definite
+		if (!CholeskyFactorizeBayesian(L, K))
+		{
+			break;
+		}
+
+		ForwardSubstitutionBayesian(L, beta_update, K);
+		BackSubstitutionBayesian(L, beta_update, K);
+		for (int a = 0; a < K; a++)
+		{
+			beta_mean[a] = beta_update[a];
+		}
+		float beta_logdet = InverseFromCholeskyVB(L, beta_covariance, temp, K);
+
+		// Expected lagged products of the residuals, E[sum_t e(t-i) e(t-j)] over q(beta)
+		for (int l = 0; l < LAGS * LAGS; l++)
+		{
+			int i = l % LAGS;
+			int j = l / LAGS;
+			float value = Syy[l];
+			for (int a = 0; a < K; a++)
+			{
+				value -= beta_mean[a] * (SXy[l * K + a] + SXy[(j + i * LAGS) * K + a]);
+				for (int b = 0; b < K; b++)
+				{
+					value += c_SXX[l * K * K + a + b * K] * (beta_mean[a] * beta_mean[b] + beta_covariance[a + b * K]);
+				}
+			}
+			Rxx[l] = value;
+		}
+
+		// Update q(a), the AR parameters regress the residual on its own past. This can not use EstimateAR4Models, which solves the
+		// Yule-Walker equations for a point estimate from one residual time series. Here the lagged products are expectations over
+		// q(beta), the posterior covariance of a is needed for the next q(beta) update and the free energy, and the order is AR_ORDER
+		float ar_logdet = 0.0f;
+		if (P > 0)
+		{
+			for (int i = 0; i < P; i++)
+			{
+				for (int j = 0; j <= i; j++)
+				{
+					L[PackedIndexBayesian(i,j)] = lambda * Rxx[(i+1) + (j+1) * LAGS] + ((i == j) ? gamma : 0.0f);
+				}
+				ar_update[i] = lambda * Rxx[(i+1)];
+			}
+
+			// Keep the previous q(a), the new q(beta) is a valid update given it
+			if (!CholeskyFactorizeBayesian(L, P))
+			{
+				break;
+			}
+
+			ForwardSubstitutionBayesian(L, ar_update, P);
+			BackSubstitutionBayesian(L, ar_update, P);
+			for (int i = 0; i < P; i++)
+			{
+				ar_mean[i] = ar_update[i];
+			}
+			ar_logdet = InverseFromCholeskyVB(L, ar_covariance, temp, P);
+		}
+
+		// Expected sum of squared innovations, for the new q(a)
+		float G = 0.0f;
+		for (int j = 0; j < LAGS; j++)
+		{
+			for (int i = 0; i < LAGS; i++)
+			{
+				float ui = (i == 0) ? 1.0f : -ar_mean[i-1];
+				float uj = (j == 0) ? 1.0f : -ar_mean[j-1];
+				float covariance = ((i > 0) && (j > 0)) ? ar_covariance[(i-1) + (j-1) * P] : 0.0f;
+				G += (ui * uj + covariance) * Rxx[i + j * LAGS];
+			}
+		}
+		G = max(G, 1e-10f);
+
+		// Update q(lambda), q(alpha) and q(gamma)
+		float beta_square = 0.0f;
+		for (int a = 0; a < K; a++)
+		{
+			beta_square += beta_mean[a] * beta_mean[a] + beta_covariance[a + a * K];
+		}
+
+		float ar_square = 0.0f;
+		for (int i = 0; i < P; i++)
+		{
+			ar_square += ar_mean[i] * ar_mean[i] + ar_covariance[i + i * P];
+		}
+
+		float lambda_shape = shape0 + 0.5f * N;
+		float lambda_rate = rate0 + 0.5f * G;
+		float alpha_shape = shape0 + 0.5f * (float)K;
+		float alpha_rate = rate0 + 0.5f * beta_square;
+		float gamma_shape = shape0 + 0.5f * (float)P;
+		float gamma_rate = rate0 + 0.5f * ar_square;
+
+		float lambda_new = lambda_shape / lambda_rate;
+		float alpha_new = alpha_shape / alpha_rate;
+
+		// Negative free energy, expected log likelihood minus the KL divergences between the posteriors and the priors
+		float log_lambda = DigammaVB(lambda_shape) - log(lambda_rate);
+		float log_alpha = DigammaVB(alpha_shape) - log(alpha_rate);
+		float F = 0.5f * N * (log_lambda - log(2.0f * (float)pi)) - 0.5f * lambda_new * G;
+		F -= 0.5f * (alpha_new * beta_square - (float)K * log_alpha - beta_logdet - (float)K);
+		F -= KLGammaVB(lambda_shape, lambda_rate, shape0, rate0);
+		F -= KLGammaVB(alpha_shape, alpha_rate, shape0, rate0);
+		if (P > 0)
+		{
+			float gamma_new = gamma_shape / gamma_rate;
+			float log_gamma = DigammaVB(gamma_shape) - log(gamma_rate);
+			F -= 0.5f * (gamma_new * ar_square - (float)P * log_gamma - ar_logdet - (float)P);
+			F -= KLGammaVB(gamma_shape, gamma_rate, shape0, rate0);
+			gamma = gamma_new;
+		}
+
+		lambda = lambda_new;
+		alpha = alpha_new;
+		valid = 1;
+
+		if ( (iteration > 0) && (myabs(F - F_old) < TOLERANCE * myabs(F)) )
+		{
+			break;
+		}
+		F_old = F;
+	}
+
+	// Posterior probability of a positive contrast, from the Gaussian posterior of the beta weights
+	for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+	{
+		float contrast_mean = 0.0f;
+		float contrast_variance = 0.0f;
+		for (int a = 0; a < K; a++)
+		{
+			contrast_mean += c_Contrasts[K * c + a] * beta_mean[a];
+			for (int b = 0; b < K; b++)
+			{
+				contrast_variance += c_Contrasts[K * c + a] * beta_covariance[a + b * K] * c_Contrasts[K * c + b];
+			}
+		}
+
+		float probability = 0.0f;
+		if (valid && (contrast_variance > 0.0f))
+		{
+			probability = 0.5f * erfc(-contrast_mean / sqrt(2.0f * contrast_variance));
+		}
+		Statistical_Maps[output_voxel + c * output_stride] = probability;
+	}
+
+	for (int a = 0; a < K; a++)
+	{
+		Beta_Volumes[output_voxel + a * output_stride] = valid ? beta_mean[a] : 0.0f;
+	}
+
+	AR1_Estimates[output_voxel] = (valid && (P > 0)) ? ar_mean[0] : 0.0f;
+	AR2_Estimates[output_voxel] = (valid && (P > 1)) ? ar_mean[1] : 0.0f;
+	AR3_Estimates[output_voxel] = (valid && (P > 2)) ? ar_mean[2] : 0.0f;
+	AR4_Estimates[output_voxel] = (valid && (P > 3)) ? ar_mean[3] : 0.0f;
+}
+
+// Generates posterior probability maps (PPMs) for all contrasts with variational Bayes, one work item per voxel of the volume
+
+__kernel void CalculateStatisticalMapsGLMVariationalBayesVolume(__global float* Statistical_Maps,
+                                                                __global float* Beta_Volumes,
+                                                                __global float* AR1_Estimates,
+                                                                __global float* AR2_Estimates,
+                                                                __global float* AR3_Estimates,
+                                                                __global float* AR4_Estimates,
+                                                                __global const float* Volumes,
+                                                                __global const float* Mask,
+                                                                __constant float* c_X_GLM,
+                                                                __constant float* c_X_Nuisance,
+                                                                __constant float* c_xtxxt_Nuisance,
+                                                                __constant float* c_Contrasts,
+                                                                __constant float* c_SXX,
+                                                                __private int DATA_W,
+                                                                __private int DATA_H,
+                                                                __private int DATA_D,
+                                                                __private int NUMBER_OF_VOLUMES,
+                                                                __private int NUMBER_OF_REGRESSORS,
+                                                                __private int NUMBER_OF_NUISANCE_REGRESSORS,
+                                                                __private int NUMBER_OF_CONTRASTS,
+                                                                __private int AR_ORDER,
+                                                                __private int MAX_ITERATIONS,
+                                                                __private float TOLERANCE)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int voxel = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+	int VOLUME_SIZE = DATA_W * DATA_H * DATA_D;
+
+	if ( Mask[voxel] != 1.0f )
+	{
+		for (int k = 0; k < NUMBER_OF_CONTRASTS; k++)
+		{
+			Statistical_Maps[voxel + k * VOLUME_SIZE] = 0.0f;
+		}
+
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			Beta_Volumes[voxel + i * VOLUME_SIZE] = 0.0f;
+		}
+
+		AR1_Estimates[voxel] = 0.0f;
+		AR2_Estimates[voxel] = 0.0f;
+		AR3_Estimates[voxel] = 0.0f;
+		AR4_Estimates[voxel] = 0.0f;
+
+		return;
+	}
+
+	VariationalBayesGLMARp(Statistical_Maps, Beta_Volumes, AR1_Estimates, AR2_Estimates, AR3_Estimates, AR4_Estimates, Volumes, voxel, VOLUME_SIZE, voxel, VOLUME_SIZE, c_X_GLM, c_X_Nuisance, c_xtxxt_Nuisance, c_Contrasts, c_SXX, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS, NUMBER_OF_NUISANCE_REGRESSORS, NUMBER_OF_CONTRASTS, AR_ORDER, MAX_ITERATIONS, TOLERANCE);
+}
+
+// Generates posterior probability maps (PPMs) for all contrasts with variational Bayes, one work item per brain voxel
+// The time series are stored as v + t * NUMBER_OF_VOXELS, the results are written to the voxels given by Voxel_Indices
+
+__kernel void CalculateStatisticalMapsGLMVariationalBayesVoxelList(__global float* Statistical_Maps,
+                                                                   __global float* Beta_Volumes,
+                                                                   __global float* AR1_Estimates,
+                                                                   __global float* AR2_Estimates,
+                                                                   __global float* AR3_Estimates,
+                                                                   __global float* AR4_Estimates,
+                                                                   __global const float* Volumes,
+                                                                   __global const int* Voxel_Indices,
+                                                                   __constant float* c_X_GLM,
+                                                                   __constant float* c_X_Nuisance,
+                                                                   __constant float* c_xtxxt_Nuisance,
+                                                                   __constant float* c_Contrasts,
+                                                                   __constant float* c_SXX,
+                                                                   __private int NUMBER_OF_VOXELS,
+                                                                   __private int VOLUME_SIZE,
+                                                                   __private int NUMBER_OF_VOLUMES,
+                                                                   __private int NUMBER_OF_REGRESSORS,
+                                                                   __private int NUMBER_OF_NUISANCE_REGRESSORS,
+                                                                   __private int NUMBER_OF_CONTRASTS,
+                                                                   __private int AR_ORDER,
+                                                                   __private int MAX_ITERATIONS,
+                                                                   __private float TOLERANCE)
+{
+	int v = get_global_id(0);
+
+	if (v >= NUMBER_OF_VOXELS)
+		return;
+
+	VariationalBayesGLMARp(Statistical_Maps, Beta_Volumes, AR1_Estimates, AR2_Estimates, AR3_Estimates, AR4_Estimates, Volumes, v, NUMBER_OF_VOXELS, Voxel_Indices[v], VOLUME_SIZE, c_X_GLM, c_X_Nuisance, c_xtxxt_Nuisance, c_Contrasts, c_SXX, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS, NUMBER_OF_NUISANCE_REGRESSORS, NUMBER_OF_CONTRASTS, AR_ORDER, MAX_ITERATIONS, TOLERANCE);
+}
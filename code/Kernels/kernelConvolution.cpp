@@ -1662,6 +1662,120 @@ __kernel void SeparableConvolutionRods_16KB_256threads(__global float *Filter_Re
 	}
 }
 
+// Recursive Gaussian smoothing (Young and van Vliet), one work-item per line
+// The cost is independent of the filter size, the coefficients B, b1, b2 and b3 are already normalized with b0
+// Zero initial conditions are used in both directions, which is the same as zero padding for the separable filters
+
+__kernel void RecursiveGaussianRows(__global float *Filter_Response,
+	                                __global const float* Volume,
+									__global const float* Certainty,
+									__private float B,
+									__private float b1,
+									__private float b2,
+									__private float b3,
+									__private int t,
+									__private int DATA_W,
+									__private int DATA_H,
+									__private int DATA_D)
+{
+	int x = get_global_id(0);
+	int z = get_global_id(1);
+
+	if ( (x >= DATA_W) || (z >= DATA_D) )
+		return;
+
+	// Causal pass
+	float w1 = 0.0f, w2 = 0.0f, w3 = 0.0f;
+	for (int y = 0; y < DATA_H; y++)
+	{
+		float pixel = Volume[Calculate4DIndex(x,y,z,t,DATA_W,DATA_H,DATA_D)] * Certainty[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+		float w = B * pixel + b1 * w1 + b2 * w2 + b3 * w3;
+		Filter_Response[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = w;
+		w3 = w2; w2 = w1; w1 = w;
+	}
+
+	// Anti-causal pass
+	w1 = 0.0f; w2 = 0.0f; w3 = 0.0f;
+	for (int y = DATA_H - 1; y >= 0; y--)
+	{
+		float w = B * Filter_Response[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] + b1 * w1 + b2 * w2 + b3 * w3;
+		Filter_Response[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = w;
+		w3 = w2; w2 = w1; w1 = w;
+	}
+}
+
+// Done in place, each work-item reads and writes the same voxels
+__kernel void RecursiveGaussianColumns(__global float* Volume,
+									   __private float B,
+									   __private float b1,
+									   __private float b2,
+									   __private float b3,
+									   __private int DATA_W,
+									   __private int DATA_H,
+									   __private int DATA_D)
+{
+	int y = get_global_id(0);
+	int z = get_global_id(1);
+
+	if ( (y >= DATA_H) || (z >= DATA_D) )
+		return;
+
+	// Causal pass
+	float w1 = 0.0f, w2 = 0.0f, w3 = 0.0f;
+	for (int x = 0; x < DATA_W; x++)
+	{
+		float w = B * Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] + b1 * w1 + b2 * w2 + b3 * w3;
+		Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = w;
+		w3 = w2; w2 = w1; w1 = w;
+	}
+
+	// Anti-causal pass
+	w1 = 0.0f; w2 = 0.0f; w3 = 0.0f;
+	for (int x = DATA_W - 1; x >= 0; x--)
+	{
+		float w = B * Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] + b1 * w1 + b2 * w2 + b3 * w3;
+		Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = w;
+		w3 = w2; w2 = w1; w1 = w;
+	}
+}
+
+__kernel void RecursiveGaussianRods(__global float *Filter_Response,
+	                                __global float* Volume,
+									__global const float* Smoothed_Certainty,
+									__private float B,
+									__private float b1,
+									__private float b2,
+									__private float b3,
+									__private int t,
+									__private int DATA_W,
+									__private int DATA_H,
+									__private int DATA_D)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if ( (x >= DATA_W) || (y >= DATA_H) )
+		return;
+
+	// Causal pass, done in place in the temporary volume, the anti-causal pass writes the result
+	float w1 = 0.0f, w2 = 0.0f, w3 = 0.0f;
+	for (int z = 0; z < DATA_D; z++)
+	{
+		float w = B * Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] + b1 * w1 + b2 * w2 + b3 * w3;
+		Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = w;
+		w3 = w2; w2 = w1; w1 = w;
+	}
+
+	// Anti-causal pass
+	w1 = 0.0f; w2 = 0.0f; w3 = 0.0f;
+	for (int z = DATA_D - 1; z >= 0; z--)
+	{
+		float w = B * Volume[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] + b1 * w1 + b2 * w2 + b3 * w3;
+		Filter_Response[Calculate4DIndex(x,y,z,t,DATA_W,DATA_H,DATA_D)] = w / Smoothed_Certainty[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+		w3 = w2; w2 = w1; w1 = w;
+	}
+}
+
 #define HALO 3
 
 #define VALID_FILTER_RESPONSES_X_CONVOLUTION_2D_24KB 90
@@ -301,6 +301,168 @@ __kernel void CalculateMaxAtomic(volatile __global int* max_value,
 }
 
 
+// Same values as in broccoli_constants.h
+#define REDUCTION_SUM 0
+#define REDUCTION_MEAN 1
+#define REDUCTION_MIN 2
+#define REDUCTION_MAX 3
+#define REDUCTION_CENTER_OF_MASS 4
+#define REDUCTION_QUALITY 5
+
+#define REDUCTION_THREADS 256
+
+float4 InitialReductionValue(int OPERATION)
+{
+	if (OPERATION == REDUCTION_MIN)
+		return (float4)(FLT_MAX, 0.0f, 0.0f, 0.0f);
+	else if (OPERATION == REDUCTION_MAX)
+		return (float4)(-FLT_MAX, 0.0f, 0.0f, 0.0f);
+	else
+		return (float4)(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+// x is the value (sum, min or max) and y the number of voxels, except for the center of mass which uses (x*m, y*m, z*m, m)
+// and the quality metrics which also sum the squared difference to the previous volume in z
+float4 CombineReductionValues(float4 a, float4 b, int OPERATION)
+{
+	if (OPERATION == REDUCTION_MIN)
+		return (float4)(fmin(a.x, b.x), a.y + b.y, 0.0f, 0.0f);
+	else if (OPERATION == REDUCTION_MAX)
+		return (float4)(fmax(a.x, b.x), a.y + b.y, 0.0f, 0.0f);
+	else
+		return a + b;
+}
+
+// First pass of a reduction, each work group loops over a part of one volume (the second dimension is the volume)
+// and writes one partial result, the partial results are combined by ReduceVolumesFinal
+__kernel void ReduceVolumes(__global float4* Partial_Results,
+	                        __global const float* Volumes,
+							__global const float* Mask,
+							__private int OPERATION,
+							__private int USE_MASK,
+							__private int DATA_W,
+							__private int DATA_H,
+							__private int DATA_D)
+{
+	__local float4 l_Values[REDUCTION_THREADS];
+
+	int tid = get_local_id(0);
+	int volume = get_global_id(1);
+	int N = DATA_W * DATA_H * DATA_D;
+
+	__global const float* Volume = Volumes + (size_t)volume * (size_t)N;
+
+	// For the quality metrics the volumes are shifted by one, the first volume is the one before the batch
+	if (OPERATION == REDUCTION_QUALITY)
+		Volume += N;
+
+	float4 value = InitialReductionValue(OPERATION);
+
+	for (int i = get_global_id(0); i < N; i += get_global_size(0))
+	{
+		if ( USE_MASK && (Mask[i] != 1.0f) )
+			continue;
+
+		float voxel = Volume[i];
+
+		if (OPERATION == REDUCTION_CENTER_OF_MASS)
+		{
+			int x = i % DATA_W;
+			int y = (i / DATA_W) % DATA_H;
+			int z = i / (DATA_W * DATA_H);
+			value += (float4)(voxel * (float)x, voxel * (float)y, voxel * (float)z, voxel);
+		}
+		else if (OPERATION == REDUCTION_QUALITY)
+		{
+			float difference = voxel - Volume[i - N];
+			value += (float4)(voxel, 1.0f, difference * difference, 0.0f);
+		}
+		else
+		{
+			value = CombineReductionValues(value, (float4)(voxel, 1.0f, 0.0f, 0.0f), OPERATION);
+		}
+	}
+
+	l_Values[tid] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	// Tree reduction in local memory, the local size is a power of two
+	for (int s = get_local_size(0) / 2; s > 0; s >>= 1)
+	{
+		if (tid < s)
+		{
+			l_Values[tid] = CombineReductionValues(l_Values[tid], l_Values[tid + s], OPERATION);
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (tid == 0)
+	{
+		Partial_Results[get_group_id(0) + volume * get_num_groups(0)] = l_Values[0];
+	}
+}
+
+// Second pass of a reduction, one work group per volume
+__kernel void ReduceVolumesFinal(__global float4* Results,
+	                             __global const float4* Partial_Results,
+								 __private int OPERATION,
+								 __private int NUMBER_OF_GROUPS,
+								 __private int RESULT_OFFSET)
+{
+	__local float4 l_Values[REDUCTION_THREADS];
+
+	int tid = get_local_id(0);
+	int volume = get_group_id(1);
+
+	float4 value = InitialReductionValue(OPERATION);
+	for (int i = tid; i < NUMBER_OF_GROUPS; i += get_local_size(0))
+	{
+		value = CombineReductionValues(value, Partial_Results[i + volume * NUMBER_OF_GROUPS], OPERATION);
+	}
+
+	l_Values[tid] = value;
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	for (int s = get_local_size(0) / 2; s > 0; s >>= 1)
+	{
+		if (tid < s)
+		{
+			l_Values[tid] = CombineReductionValues(l_Values[tid], l_Values[tid + s], OPERATION);
+		}
+		barrier(CLK_LOCAL_MEM_FENCE);
+	}
+
+	if (tid == 0)
+	{
+		value = l_Values[0];
+
+		if (OPERATION == REDUCTION_MEAN)
+		{
+			value.x = (value.y > 0.0f) ? value.x / value.y : 0.0f;
+		}
+		else if (OPERATION == REDUCTION_CENTER_OF_MASS)
+		{
+			if (value.w != 0.0f)
+			{
+				value.x /= value.w;
+				value.y /= value.w;
+				value.z /= value.w;
+			}
+		}
+		else if (OPERATION == REDUCTION_QUALITY)
+		{
+			if (value.y > 0.0f)
+			{
+				value.x /= value.y;
+				value.z /= value.y;
+			}
+		}
+
+		Results[volume + RESULT_OFFSET] = value;
+	}
+}
+
+
 
 __kernel void ThresholdVolume(__global float* Thresholded_Volume, 
 	                          __global const float* Volume, 
@@ -326,6 +488,67 @@ __kernel void ThresholdVolume(__global float* Thresholded_Volume,
 	}
 }
 
+// Binary erosion of a mask with the 6-connected neighbourhood, voxels outside the volume count as background
+__kernel void ErodeMask(__global float* Eroded_Mask, 
+	                    __global const float* Mask, 
+						__private int DATA_W, 
+						__private int DATA_H, 
+						__private int DATA_D)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+    if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+        return;
+
+	float value = 1.0f;
+
+	if ( (Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f) ||
+	     (x == 0) || (x == (DATA_W - 1)) || (y == 0) || (y == (DATA_H - 1)) || (z == 0) || (z == (DATA_D - 1)) )
+	{
+		value = 0.001f;
+	}
+	else if ( (Mask[Calculate3DIndex(x-1,y,z,DATA_W,DATA_H)] != 1.0f) || (Mask[Calculate3DIndex(x+1,y,z,DATA_W,DATA_H)] != 1.0f) ||
+	          (Mask[Calculate3DIndex(x,y-1,z,DATA_W,DATA_H)] != 1.0f) || (Mask[Calculate3DIndex(x,y+1,z,DATA_W,DATA_H)] != 1.0f) ||
+	          (Mask[Calculate3DIndex(x,y,z-1,DATA_W,DATA_H)] != 1.0f) || (Mask[Calculate3DIndex(x,y,z+1,DATA_W,DATA_H)] != 1.0f) )
+	{
+		value = 0.001f;
+	}
+
+	Eroded_Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = value;
+}
+
+// Binary dilation of a mask with the 6-connected neighbourhood
+__kernel void DilateMask(__global float* Dilated_Mask, 
+	                     __global const float* Mask, 
+						 __private int DATA_W, 
+						 __private int DATA_H, 
+						 __private int DATA_D)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+    if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+        return;
+
+	float value = 0.001f;
+
+	if ( (Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] == 1.0f) ||
+	     ( (x > 0) && (Mask[Calculate3DIndex(x-1,y,z,DATA_W,DATA_H)] == 1.0f) ) ||
+	     ( (x < (DATA_W - 1)) && (Mask[Calculate3DIndex(x+1,y,z,DATA_W,DATA_H)] == 1.0f) ) ||
+	     ( (y > 0) && (Mask[Calculate3DIndex(x,y-1,z,DATA_W,DATA_H)] == 1.0f) ) ||
+	     ( (y < (DATA_H - 1)) && (Mask[Calculate3DIndex(x,y+1,z,DATA_W,DATA_H)] == 1.0f) ) ||
+	     ( (z > 0) && (Mask[Calculate3DIndex(x,y,z-1,DATA_W,DATA_H)] == 1.0f) ) ||
+	     ( (z < (DATA_D - 1)) && (Mask[Calculate3DIndex(x,y,z+1,DATA_W,DATA_H)] == 1.0f) ) )
+	{
+		value = 1.0f;
+	}
+
+	Dilated_Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = value;
+}
+
 
 
 __kernel void RemoveMean(__global float* Volumes, 
@@ -604,6 +827,38 @@ __kernel void MemsetFloat2(__global float2 *Data,
 	Data[i] = values;
 }
 
+// Copies the results for one block of brain voxels to the correct voxels of full volumes,
+// the block is stored as BLOCK_W x BLOCK_H voxels, one volume after the other
+__kernel void ScatterBlockVolumes(__global float* Volumes,
+	                              __global const float* Block_Volumes,
+	                              __global const int* Voxel_Indices,
+	                              __private int NUMBER_OF_BLOCK_VOXELS,
+	                              __private int BLOCK_W,
+	                              __private int BLOCK_H,
+	                              __private int DATA_W,
+	                              __private int DATA_H,
+	                              __private int DATA_D,
+	                              __private int NUMBER_OF_VOLUMES)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if (x >= BLOCK_W || y >= BLOCK_H)
+		return;
+
+	int v = x + y * BLOCK_W;
+
+	if (v >= NUMBER_OF_BLOCK_VOXELS)
+		return;
+
+	int idx = Voxel_Indices[v];
+
+	for (int i = 0; i < NUMBER_OF_VOLUMES; i++)
+	{
+		Volumes[idx + i * DATA_W * DATA_H * DATA_D] = Block_Volumes[v + i * BLOCK_W * BLOCK_H];
+	}
+}
+
 float InterpolateCubic(float p0, float p1, float p2, float p3, float delta)
 {
    float a0,a1,a2,a3,delta2;
@@ -1675,4 +1675,319 @@ __kernel void CopyVolumeToNew(__global float* New_Volume,
 }
 
 
+// Interpolation modes, same values as in broccoli_constants.h
+#define NEAREST 0
+#define LINEAR 1
+#define CUBIC 2
+#define BSPLINE 3
+#define LANCZOS 4
+
+#define LANCZOS_RADIUS 3
+#define BSPLINE_HORIZON 16
+
+// Windowed sinc, with a window of the same width as the sinc kernel
+float lanczos(float t)
+{
+	t = fabs(t);
+	if (t < 0.00001f)
+		return 1.0f;
+	else if (t >= (float)LANCZOS_RADIUS)
+		return 0.0f;
+
+	float pt = M_PI_F * t;
+	return (float)LANCZOS_RADIUS * sin(pt) * sin(pt / (float)LANCZOS_RADIUS) / (pt * pt);
+}
+
+// Converts volumes to cubic B-spline coefficients along one dimension (0 = x, 1 = y, 2 = z), inplace,
+// with a causal and an anti-causal recursive filter (mirrored boundaries). One work item per line
+__kernel void BSplinePrefilter(__global float* Volumes,
+		                       __private int DATA_W,
+		                       __private int DATA_H,
+		                       __private int DATA_D,
+		                       __private int DIMENSION)
+{
+	int a = get_global_id(0);
+	int b = get_global_id(1);
+	int v = get_global_id(2);
+
+	int N, stride, start;
+	if (DIMENSION == 0)
+	{
+		if ((a >= DATA_H) || (b >= DATA_D))
+			return;
+		N = DATA_W;
+		stride = 1;
+		start = Calculate4DIndex(0,a,b,v,DATA_W,DATA_H,DATA_D);
+	}
+	else if (DIMENSION == 1)
+	{
+		if ((a >= DATA_W) || (b >= DATA_D))
+			return;
+		N = DATA_H;
+		stride = DATA_W;
+		start = Calculate4DIndex(a,0,b,v,DATA_W,DATA_H,DATA_D);
+	}
+	else
+	{
+		if ((a >= DATA_W) || (b >= DATA_H))
+			return;
+		N = DATA_D;
+		stride = DATA_W * DATA_H;
+		start = Calculate4DIndex(a,b,0,v,DATA_W,DATA_H,DATA_D);
+	}
+
+	if (N < 2)
+		return;
+
+	__global float* c = &Volumes[start];
+
+	const float pole = sqrt(3.0f) - 2.0f;
+	const float gain = (1.0f - pole) * (1.0f - 1.0f / pole);
+
+	for (int k = 0; k < N; k++)
+	{
+		c[k * stride] *= gain;
+	}
+
+	// First causal coefficient, the sum is truncated where the pole has decayed
+	int horizon = min(N, BSPLINE_HORIZON);
+	float zk = pole;
+	float sum = c[0];
+	for (int k = 1; k < horizon; k++)
+	{
+		sum += zk * c[k * stride];
+		zk *= pole;
+	}
+	c[0] = sum;
+
+	// Causal filter
+	for (int k = 1; k < N; k++)
+	{
+		c[k * stride] += pole * c[(k - 1) * stride];
+	}
+
+	// Anti-causal filter
+	c[(N - 1) * stride] = (pole / (pole * pole - 1.0f)) * (c[(N - 1) * stride] + pole * c[(N - 2) * stride]);
+	for (int k = N - 2; k >= 0; k--)
+	{
+		c[k * stride] = pole * (c[(k + 1) * stride] - c[k * stride]);
+	}
+}
+
+// Calculates, for every voxel in the reference space, which voxel coordinate to read from in the original space.
+// The (optional) displacement field is applied first, followed by one affine transformation,
+// which is a composition of all the linear steps (calculated on the host)
+__kernel void CreateCombinedCoordinateField(__global float* d_Coordinate_Field_X,
+		                                    __global float* d_Coordinate_Field_Y,
+		                                    __global float* d_Coordinate_Field_Z,
+		                                    __global const float* d_Displacement_Field_X,
+		                                    __global const float* d_Displacement_Field_Y,
+		                                    __global const float* d_Displacement_Field_Z,
+		                                    __constant float* c_Affine_Matrix,
+		                                    __private int USE_DISPLACEMENT_FIELD,
+		                                    __private int DATA_W,
+		                                    __private int DATA_H,
+		                                    __private int DATA_D)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if ((x >= DATA_W) || (y >= DATA_H) || (z >= DATA_D))
+		return;
+
+	int idx = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+
+	float xf = (float)x;
+	float yf = (float)y;
+	float zf = (float)z;
+
+	if (USE_DISPLACEMENT_FIELD == 1)
+	{
+		xf += d_Displacement_Field_X[idx];
+		yf += d_Displacement_Field_Y[idx];
+		zf += d_Displacement_Field_Z[idx];
+	}
+
+	// Affine matrix stored row by row, 3 x 4
+	d_Coordinate_Field_X[idx] = c_Affine_Matrix[0] * xf + c_Affine_Matrix[1] * yf + c_Affine_Matrix[2]  * zf + c_Affine_Matrix[3];
+	d_Coordinate_Field_Y[idx] = c_Affine_Matrix[4] * xf + c_Affine_Matrix[5] * yf + c_Affine_Matrix[6]  * zf + c_Affine_Matrix[7];
+	d_Coordinate_Field_Z[idx] = c_Affine_Matrix[8] * xf + c_Affine_Matrix[9] * yf + c_Affine_Matrix[10] * zf + c_Affine_Matrix[11];
+}
+
+int ClampIndex(int i, int DATA_N)
+{
+	return min(max(i, 0), DATA_N - 1);
+}
+
+// Resamples a stack of volumes (starting at VOLUME_OFFSET) through one coordinate field. The interpolation
+// weights and neighbour indices are calculated once per voxel, and are then used for all volumes.
+// Voxels that map more than half a voxel outside the original volume are set to zero.
+__kernel void InterpolateVolumesCombined(__global float* New_Volumes,
+		                                 __global const float* Volumes,
+		                                 __global const float* d_Coordinate_Field_X,
+		                                 __global const float* d_Coordinate_Field_Y,
+		                                 __global const float* d_Coordinate_Field_Z,
+		                                 __private int DATA_W,
+		                                 __private int DATA_H,
+		                                 __private int DATA_D,
+		                                 __private int NEW_DATA_W,
+		                                 __private int NEW_DATA_H,
+		                                 __private int NEW_DATA_D,
+		                                 __private int VOLUME_OFFSET,
+		                                 __private int NUMBER_OF_VOLUMES,
+		                                 __private int INTERPOLATION_MODE)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if ((x >= NEW_DATA_W) || (y >= NEW_DATA_H) || (z >= NEW_DATA_D))
+		return;
+
+	int idx = Calculate3DIndex(x,y,z,NEW_DATA_W,NEW_DATA_H);
+
+	float xf = d_Coordinate_Field_X[idx];
+	float yf = d_Coordinate_Field_Y[idx];
+	float zf = d_Coordinate_Field_Z[idx];
+
+	if ( (xf < -0.5f) || (yf < -0.5f) || (zf < -0.5f) || (xf > ((float)DATA_W - 0.5f)) || (yf > ((float)DATA_H - 0.5f)) || (zf > ((float)DATA_D - 0.5f)) )
+	{
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			New_Volumes[Calculate4DIndex(x,y,z,v,NEW_DATA_W,NEW_DATA_H,NEW_DATA_D)] = 0.0f;
+		}
+		return;
+	}
+
+	if (INTERPOLATION_MODE == NEAREST)
+	{
+		int xi = ClampIndex((int)round(xf), DATA_W);
+		int yi = ClampIndex((int)round(yf), DATA_H);
+		int zi = ClampIndex((int)round(zf), DATA_D);
+		int original_idx = Calculate3DIndex(xi,yi,zi,DATA_W,DATA_H);
+
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			New_Volumes[Calculate4DIndex(x,y,z,v,NEW_DATA_W,NEW_DATA_H,NEW_DATA_D)] = Volumes[original_idx + (v + VOLUME_OFFSET) * DATA_W * DATA_H * DATA_D];
+		}
+	}
+	else if (INTERPOLATION_MODE == LINEAR)
+	{
+		float xfloor = floor(xf);
+		float yfloor = floor(yf);
+		float zfloor = floor(zf);
+
+		float wx = xf - xfloor;
+		float wy = yf - yfloor;
+		float wz = zf - zfloor;
+
+		int x0 = ClampIndex((int)xfloor, DATA_W);
+		int y0 = ClampIndex((int)yfloor, DATA_H);
+		int z0 = ClampIndex((int)zfloor, DATA_D);
+		int x1 = ClampIndex((int)xfloor + 1, DATA_W);
+		int y1 = ClampIndex((int)yfloor + 1, DATA_H);
+		int z1 = ClampIndex((int)zfloor + 1, DATA_D);
+
+		int idx000 = Calculate3DIndex(x0,y0,z0,DATA_W,DATA_H);
+		int idx100 = Calculate3DIndex(x1,y0,z0,DATA_W,DATA_H);
+		int idx010 = Calculate3DIndex(x0,y1,z0,DATA_W,DATA_H);
+		int idx110 = Calculate3DIndex(x1,y1,z0,DATA_W,DATA_H);
+		int idx001 = Calculate3DIndex(x0,y0,z1,DATA_W,DATA_H);
+		int idx101 = Calculate3DIndex(x1,y0,z1,DATA_W,DATA_H);
+		int idx011 = Calculate3DIndex(x0,y1,z1,DATA_W,DATA_H);
+		int idx111 = Calculate3DIndex(x1,y1,z1,DATA_W,DATA_H);
+
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			__global const float* Volume = &Volumes[(v + VOLUME_OFFSET) * DATA_W * DATA_H * DATA_D];
+
+			float c00 = Volume[idx000] * (1.0f - wx) + Volume[idx100] * wx;
+			float c10 = Volume[idx010] * (1.0f - wx) + Volume[idx110] * wx;
+			float c01 = Volume[idx001] * (1.0f - wx) + Volume[idx101] * wx;
+			float c11 = Volume[idx011] * (1.0f - wx) + Volume[idx111] * wx;
+
+			float c0 = c00 * (1.0f - wy) + c10 * wy;
+			float c1 = c01 * (1.0f - wy) + c11 * wy;
+
+			New_Volumes[Calculate4DIndex(x,y,z,v,NEW_DATA_W,NEW_DATA_H,NEW_DATA_D)] = c0 * (1.0f - wz) + c1 * wz;
+		}
+	}
+	else
+	{
+		// Separable kernels, cubic B-spline (same weights as InterpolateVolumeCubicLinear) with 4 x 4 x 4 neighbours,
+		// or Lanczos with 6 x 6 x 6 neighbours. For BSPLINE the volumes have been prefiltered (BSplinePrefilter),
+		// such that the original values are interpolated instead of smoothed
+		int TAPS = 4;
+		int FIRST = -1;
+		if (INTERPOLATION_MODE == LANCZOS)
+		{
+			TAPS = 2 * LANCZOS_RADIUS;
+			FIRST = 1 - LANCZOS_RADIUS;
+		}
+
+		float xfloor = floor(xf);
+		float yfloor = floor(yf);
+		float zfloor = floor(zf);
+
+		float wx[2 * LANCZOS_RADIUS], wy[2 * LANCZOS_RADIUS], wz[2 * LANCZOS_RADIUS];
+		int xi[2 * LANCZOS_RADIUS], yi[2 * LANCZOS_RADIUS], zi[2 * LANCZOS_RADIUS];
+		float sumx = 0.0f, sumy = 0.0f, sumz = 0.0f;
+		for (int i = 0; i < TAPS; i++)
+		{
+			if (INTERPOLATION_MODE == LANCZOS)
+			{
+				wx[i] = lanczos((float)(i + FIRST) - (xf - xfloor));
+				wy[i] = lanczos((float)(i + FIRST) - (yf - yfloor));
+				wz[i] = lanczos((float)(i + FIRST) - (zf - zfloor));
+			}
+			else
+			{
+				wx[i] = bspline((float)(i + FIRST) - (xf - xfloor));
+				wy[i] = bspline((float)(i + FIRST) - (yf - yfloor));
+				wz[i] = bspline((float)(i + FIRST) - (zf - zfloor));
+			}
+			sumx += wx[i];
+			sumy += wy[i];
+			sumz += wz[i];
+			xi[i] = ClampIndex((int)xfloor + i + FIRST, DATA_W);
+			yi[i] = ClampIndex((int)yfloor + i + FIRST, DATA_H);
+			zi[i] = ClampIndex((int)zfloor + i + FIRST, DATA_D);
+		}
+
+		// The truncated Lanczos weights do not sum to one
+		for (int i = 0; i < TAPS; i++)
+		{
+			wx[i] /= sumx;
+			wy[i] /= sumy;
+			wz[i] /= sumz;
+		}
+
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			__global const float* Volume = &Volumes[(v + VOLUME_OFFSET) * DATA_W * DATA_H * DATA_D];
+
+			// Tensor product, one dimension at a time
+			float result = 0.0f;
+			for (int k = 0; k < TAPS; k++)
+			{
+				float plane = 0.0f;
+				for (int j = 0; j < TAPS; j++)
+				{
+					int row_idx = Calculate3DIndex(0,yi[j],zi[k],DATA_W,DATA_H);
+					float row = 0.0f;
+					for (int i = 0; i < TAPS; i++)
+					{
+						row += Volume[row_idx + xi[i]] * wx[i];
+					}
+					plane += row * wy[j];
+				}
+				result += plane * wz[k];
+			}
+
+			New_Volumes[Calculate4DIndex(x,y,z,v,NEW_DATA_W,NEW_DATA_H,NEW_DATA_D)] = result;
+		}
+	}
+}
+
 
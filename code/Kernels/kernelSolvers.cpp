@@ -0,0 +1,981 @@
+
+/*
+ BROCCOLI: Software for Fast fMRI Analysis on Many-Core CPUs and GPUs
+ Copyright (C) <2013>  Anders Eklund, andek034@gmail.com
+
+ This program is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE
+ FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ DEALINGS IN THE SOFTWARE.
+ */
+
+// Batched solvers for many small independent systems of equations, one system per work item.
+// The matrices are stored in private memory, so the system size is limited to MAX_BATCHED_SOLVER_SIZE
+
+// Same value as in broccoli_constants.h
+#define MAX_BATCHED_SOLVER_SIZE 32
+#define MAX_BATCHED_SOLVER_PACKED_SIZE 528
+
+// Help functions
+int Calculate2DIndex(int x, int y, int DATA_W)
+{
+    return x + y * DATA_W;
+}
+
+int Calculate3DIndex(int x, int y, int z, int DATA_W, int DATA_H)
+{
+    return x + y * DATA_W + z * DATA_W * DATA_H;
+}
+
+int Calculate4DIndex(int x, int y, int z, int t, int DATA_W, int DATA_H, int DATA_D)
+{
+    return x + y * DATA_W + z * DATA_W * DATA_H + t * DATA_W * DATA_H * DATA_D;
+}
+
+// Index of element (i,j), i >= j, in a lower triangle stored row by row
+int PackedIndex(int i, int j)
+{
+	return i * (i + 1) / 2 + j;
+}
+
+// In place Cholesky factorization A = L L^T, of a symmetric positive definite matrix stored as a packed lower triangle
+// Returns 0 if the matrix is not positive definite
+int CholeskyFactorize(__private float* A,
+                      int N)
+{
+	for (int j = 0; j < N; j++)
+	{
+		float diagonal = A[PackedIndex(j,j)];
+		for (int k = 0; k < j; k++)
+		{
+			diagonal -= A[PackedIndex(j,k)] * A[PackedIndex(j,k)];
+		}
+
+		if (diagonal <= 0.0f)
+		{
+			return 0;
+		}
+
+		diagonal = sqrt(diagonal);
+		A[PackedIndex(j,j)] = diagonal;
+
+		for (int i = j + 1; i < N; i++)
+		{
+			float value = A[PackedIndex(i,j)];
+			for (int k = 0; k < j; k++)
+			{
+				value -= A[PackedIndex(i,k)] * A[PackedIndex(j,k)];
+			}
+			A[PackedIndex(i,j)] = value / diagonal;
+		}
+	}
+
+	return 1;
+}
+
+// Solves L L^T x = b, b is overwritten with x
+void CholeskySolve(__private const float* L,
+                   __private float* b,
+                   int N)
+{
+	for (int i = 0; i < N; i++)
+	{
+		float value = b[i];
+		for (int k = 0; k < i; k++)
+		{
+			value -= L[PackedIndex(i,k)] * b[k];
+		}
+		b[i] = value / L[PackedIndex(i,i)];
+	}
+
+	for (int i = N - 1; i >= 0; i--)
+	{
+		float value = b[i];
+		for (int k = i + 1; k < N; k++)
+		{
+			value -= L[PackedIndex(k,i)] * b[k];
+		}
+		b[i] = value / L[PackedIndex(i,i)];
+	}
+}
+
+// In place factorization A = L D L^T without pivoting, of a symmetric matrix stored as a packed lower triangle
+// L has a unit diagonal, D is stored on the diagonal. Returns 0 if a pivot is zero
+int LDLFactorize(__private float* A,
+                 int N)
+{
+	for (int j = 0; j < N; j++)
+	{
+		float diagonal = A[PackedIndex(j,j)];
+		for (int k = 0; k < j; k++)
+		{
+			diagonal -= A[PackedIndex(j,k)] * A[PackedIndex(j,k)] * A[PackedIndex(k,k)];
+		}
+
+		if (diagonal == 0.0f)
+		{
+			return 0;
+		}
+
+		A[PackedIndex(j,j)] = diagonal;
+
+		for (int i = j + 1; i < N; i++)
+		{
+			float value = A[PackedIndex(i,j)];
+			for (int k = 0; k < j; k++)
+			{
+				value -= A[PackedIndex(i,k)] * A[PackedIndex(j,k)] * A[PackedIndex(k,k)];
+			}
+			A[PackedIndex(i,j)] = value / diagonal;
+		}
+	}
+
+	return 1;
+}
+
+// Solves L D L^T x = b, b is overwritten with x
+void LDLSolve(__private const float* L,
+              __private float* b,
+              int N)
+{
+	for (int i = 0; i < N; i++)
+	{
+		float value = b[i];
+		for (int k = 0; k < i; k++)
+		{
+			value -= L[PackedIndex(i,k)] * b[k];
+		}
+		b[i] = value;
+	}
+
+	for (int i = 0; i < N; i++)
+	{
+		b[i] /= L[PackedIndex(i,i)];
+	}
+
+	for (int i = N - 1; i >= 0; i--)
+	{
+		float value = b[i];
+		for (int k = i + 1; k < N; k++)
+		{
+			value -= L[PackedIndex(k,i)] * b[k];
+		}
+		b[i] = value;
+	}
+}
+
+// In place Householder QR factorization of a M x N matrix (M >= N) stored column by column
+// R is stored in the upper triangle, the Householder vectors (with an implicit 1 on the diagonal) below the diagonal
+// Returns 0 if the matrix does not have full column rank
+int QRFactorize(__private float* A,
+                __private float* tau,
+                int M,
+                int N)
+{
+	for (int j = 0; j < N; j++)
+	{
+		float norm = 0.0f;
+		for (int i = j; i < M; i++)
+		{
+			norm += A[i + j * M] * A[i + j * M];
+		}
+		norm = sqrt(norm);
+
+		if (norm == 0.0f)
+		{
+			return 0;
+		}
+
+		// Choose the sign that avoids cancellation
+		float alpha = (A[j + j * M] > 0.0f) ? -norm : norm;
+		float v0 = A[j + j * M] - alpha;
+
+		for (int i = j + 1; i < M; i++)
+		{
+			A[i + j * M] /= v0;
+		}
+		tau[j] = -v0 / alpha;
+		A[j + j * M] = alpha;
+
+		// Apply the reflection to the remaining columns
+		for (int k = j + 1; k < N; k++)
+		{
+			float value = A[j + k * M];
+			for (int i = j + 1; i < M; i++)
+			{
+				value += A[i + j * M] * A[i + k * M];
+			}
+			value *= tau[j];
+
+			A[j + k * M] -= value;
+			for (int i = j + 1; i < M; i++)
+			{
+				A[i + k * M] -= value * A[i + j * M];
+			}
+		}
+	}
+
+	return 1;
+}
+
+// Least squares solution of A x = b, using the factorization from QRFactorize
+// b has M elements and is overwritten, x is returned in the first N elements
+void QRSolve(__private const float* A,
+             __private const float* tau,
+             __private float* b,
+             int M,
+             int N)
+{
+	// Calculate Q^T b
+	for (int j = 0; j < N; j++)
+	{
+		float value = b[j];
+		for (int i = j + 1; i < M; i++)
+		{
+			value += A[i + j * M] * b[i];
+		}
+		value *= tau[j];
+
+		b[j] -= value;
+		for (int i = j + 1; i < M; i++)
+		{
+			b[i] -= value * A[i + j * M];
+		}
+	}
+
+	// Back substitution with R
+	for (int i = N - 1; i >= 0; i--)
+	{
+		float value = b[i];
+		for (int k = i + 1; k < N; k++)
+		{
+			value -= A[i + k * M] * b[k];
+		}
+		b[i] = value / A[i + i * M];
+	}
+}
+
+// The batched solvers below solve one system A X = B per work item.
+// All arrays are interleaved, element (i,j) of system s is stored at s + (i + j * ROWS) * NUMBER_OF_SYSTEMS,
+// such that neighbouring work items read neighbouring values. The right hand sides are stored as the columns of B.
+// Status is set to 1 for systems that were solved and to 0 for singular systems, which get a zero solution.
+
+// Symmetric positive definite N x N matrices, only the lower triangle is used
+__kernel void SolveCholeskyBatched(__global float* Solutions,
+                                   __global int* Status,
+                                   __global const float* Matrices,
+                                   __global const float* Right_Hand_Sides,
+                                   __private int N,
+                                   __private int NUMBER_OF_RIGHT_HAND_SIDES,
+                                   __private int NUMBER_OF_SYSTEMS)
+{
+	int s = get_global_id(0);
+
+	if (s >= NUMBER_OF_SYSTEMS)
+		return;
+
+	float L[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float b[MAX_BATCHED_SOLVER_SIZE];
+
+	for (int i = 0; i < N; i++)
+	{
+		for (int j = 0; j <= i; j++)
+		{
+			L[PackedIndex(i,j)] = Matrices[s + (i + j * N) * NUMBER_OF_SYSTEMS];
+		}
+	}
+
+	int solved = CholeskyFactorize(L, N);
+	Status[s] = solved;
+
+	for (int r = 0; r < NUMBER_OF_RIGHT_HAND_SIDES; r++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			b[i] = Right_Hand_Sides[s + (i + r * N) * NUMBER_OF_SYSTEMS];
+		}
+
+		if (solved)
+		{
+			CholeskySolve(L, b, N);
+		}
+
+		for (int i = 0; i < N; i++)
+		{
+			Solutions[s + (i + r * N) * NUMBER_OF_SYSTEMS] = solved ? b[i] : 0.0f;
+		}
+	}
+}
+
+// Symmetric N x N matrices, only the lower triangle is used
+__kernel void SolveLDLBatched(__global float* Solutions,
+                              __global int* Status,
+                              __global const float* Matrices,
+                              __global const float* Right_Hand_Sides,
+                              __private int N,
+                              __private int NUMBER_OF_RIGHT_HAND_SIDES,
+                              __private int NUMBER_OF_SYSTEMS)
+{
+	int s = get_global_id(0);
+
+	if (s >= NUMBER_OF_SYSTEMS)
+		return;
+
+	float L[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float b[MAX_BATCHED_SOLVER_SIZE];
+
+	for (int i = 0; i < N; i++)
+	{
+		for (int j = 0; j <= i; j++)
+		{
+			L[PackedIndex(i,j)] = Matrices[s + (i + j * N) * NUMBER_OF_SYSTEMS];
+		}
+	}
+
+	int solved = LDLFactorize(L, N);
+	Status[s] = solved;
+
+	for (int r = 0; r < NUMBER_OF_RIGHT_HAND_SIDES; r++)
+	{
+		for (int i = 0; i < N; i++)
+		{
+			b[i] = Right_Hand_Sides[s + (i + r * N) * NUMBER_OF_SYSTEMS];
+		}
+
+		if (solved)
+		{
+			LDLSolve(L, b, N);
+		}
+
+		for (int i = 0; i < N; i++)
+		{
+			Solutions[s + (i + r * N) * NUMBER_OF_SYSTEMS] = solved ? b[i] : 0.0f;
+		}
+	}
+}
+
+// M x N matrices (M >= N), least squares solutions, the right hand sides have M rows and the solutions N rows
+__kernel void SolveQRBatched(__global float* Solutions,
+                             __global int* Status,
+                             __global const float* Matrices,
+                             __global const float* Right_Hand_Sides,
+                             __private int M,
+                             __private int N,
+                             __private int NUMBER_OF_RIGHT_HAND_SIDES,
+                             __private int NUMBER_OF_SYSTEMS)
+{
+	int s = get_global_id(0);
+
+	if (s >= NUMBER_OF_SYSTEMS)
+		return;
+
+	float A[MAX_BATCHED_SOLVER_SIZE * MAX_BATCHED_SOLVER_SIZE];
+	float tau[MAX_BATCHED_SOLVER_SIZE];
+	float b[MAX_BATCHED_SOLVER_SIZE];
+
+	for (int j = 0; j < N; j++)
+	{
+		for (int i = 0; i < M; i++)
+		{
+			A[i + j * M] = Matrices[s + (i + j * M) * NUMBER_OF_SYSTEMS];
+		}
+	}
+
+	int solved = QRFactorize(A, tau, M, N);
+	Status[s] = solved;
+
+	for (int r = 0; r < NUMBER_OF_RIGHT_HAND_SIDES; r++)
+	{
+		for (int i = 0; i < M; i++)
+		{
+			b[i] = Right_Hand_Sides[s + (i + r * M) * NUMBER_OF_SYSTEMS];
+		}
+
+		if (solved)
+		{
+			QRSolve(A, tau, b, M, N);
+		}
+
+		for (int i = 0; i < N; i++)
+		{
+			Solutions[s + (i + r * N) * NUMBER_OF_SYSTEMS] = solved ? b[i] : 0.0f;
+		}
+	}
+}
+
+// Applies the AR(4) whitening of one voxel to one row (timepoint) of the design matrix, same as for the data in ApplyWhiteningAR4
+// Invalid and censored timepoints are set to 0, since they should not affect the estimates
+void WhitenedDesignMatrixRow(__private float* row,
+                             __global const float* X_GLM,
+                             int t,
+                             float AR1,
+                             float AR2,
+                             float AR3,
+                             float AR4,
+                             int DATA_T,
+                             int NUMBER_OF_REGRESSORS,
+                             int NUMBER_OF_INVALID_TIMEPOINTS,
+                             __constant float* c_Censored_Timepoints)
+{
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		if ( (t < NUMBER_OF_INVALID_TIMEPOINTS) || (c_Censored_Timepoints[t] == 0.0f) )
+		{
+			row[r] = 0.0f;
+			continue;
+		}
+
+		__global const float* regressor = &X_GLM[r * DATA_T];
+
+		float value = regressor[t];
+		if (t >= 1)
+			value -= AR1 * regressor[t - 1];
+		if (t >= 2)
+			value -= AR2 * regressor[t - 2];
+		if (t >= 3)
+			value -= AR3 * regressor[t - 3];
+		if (t >= 4)
+			value -= AR4 * regressor[t - 4];
+		row[r] = value;
+	}
+}
+
+// Forms X^T X for the whitened design matrix of one voxel and calculates the Cholesky factorization
+// The matrix is scaled by its diagonal first, (X^T X)^-1 is then scale * (L L^T)^-1 * scale
+int FactorizeWhitenedNormalEquations(__private float* L,
+                                     __private float* scale,
+                                     __global const float* X_GLM,
+                                     float AR1,
+                                     float AR2,
+                                     float AR3,
+                                     float AR4,
+                                     int DATA_T,
+                                     int NUMBER_OF_REGRESSORS,
+                                     int NUMBER_OF_INVALID_TIMEPOINTS,
+                                     __constant float* c_Censored_Timepoints)
+{
+	float row[MAX_BATCHED_SOLVER_SIZE];
+
+	for (int i = 0; i < PackedIndex(NUMBER_OF_REGRESSORS,0); i++)
+	{
+		L[i] = 0.0f;
+	}
+
+	for (int t = NUMBER_OF_INVALID_TIMEPOINTS; t < DATA_T; t++)
+	{
+		WhitenedDesignMatrixRow(row, X_GLM, t, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			for (int j = 0; j <= i; j++)
+			{
+				L[PackedIndex(i,j)] += row[i] * row[j];
+			}
+		}
+	}
+
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		scale[i] = (L[PackedIndex(i,i)] > 0.0f) ? rsqrt(L[PackedIndex(i,i)]) : 1.0f;
+	}
+
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		for (int j = 0; j <= i; j++)
+		{
+			L[PackedIndex(i,j)] *= scale[i] * scale[j];
+		}
+	}
+
+	return CholeskyFactorize(L, NUMBER_OF_REGRESSORS);
+}
+
+// Calculates (X^T X)^-1 v for the scaled factorization from FactorizeWhitenedNormalEquations, v is overwritten
+void SolveWhitenedNormalEquations(__private const float* L,
+                                  __private const float* scale,
+                                  __private float* v,
+                                  int NUMBER_OF_REGRESSORS)
+{
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		v[r] *= scale[r];
+	}
+
+	CholeskySolve(L, v, NUMBER_OF_REGRESSORS);
+
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		v[r] *= scale[r];
+	}
+}
+
+// The design whitening kernels below replace the host loops in WhitenDesignMatricesInverse / TTest / FTest.
+// One work item per voxel, the AR parameters and the mask are read at slice z + SLICE (SLICE is 0 for full volumes),
+// while the voxel numbers and GLM scalars have the size of the launched volume (DATA_W x DATA_H x DATA_D).
+// The voxel specific matrices are only stored for brain voxels, voxel number v at v * NUMBER_OF_REGRESSORS * DATA_T.
+
+// Calculates the pseudo inverse (X^T X)^-1 X^T of the whitened design matrix
+__kernel void WhitenDesignMatricesInverse(__global float* xtxxt_GLM,
+                                          __global const float* X_GLM,
+                                          __global const float* AR1_Estimates,
+                                          __global const float* AR2_Estimates,
+                                          __global const float* AR3_Estimates,
+                                          __global const float* AR4_Estimates,
+                                          __global const float* Mask,
+                                          __global const float* Voxel_Numbers,
+                                          __private int DATA_W,
+                                          __private int DATA_H,
+                                          __private int DATA_D,
+                                          __private int DATA_T,
+                                          __private int NUMBER_OF_REGRESSORS,
+                                          __private int NUMBER_OF_INVALID_TIMEPOINTS,
+                                          __private int SLICE,
+                                          __constant float* c_Censored_Timepoints)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int idx = Calculate3DIndex(x,y,z + SLICE,DATA_W,DATA_H);
+
+	if ( Mask[idx] != 1.0f )
+		return;
+
+	int voxel_number = (int)Voxel_Numbers[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+	__global float* xtxxt = &xtxxt_GLM[voxel_number * NUMBER_OF_REGRESSORS * DATA_T];
+
+	float AR1 = AR1_Estimates[idx];
+	float AR2 = AR2_Estimates[idx];
+	float AR3 = AR3_Estimates[idx];
+	float AR4 = AR4_Estimates[idx];
+
+	float L[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float scale[MAX_BATCHED_SOLVER_SIZE];
+	float row[MAX_BATCHED_SOLVER_SIZE];
+
+	int solved = FactorizeWhitenedNormalEquations(L, scale, X_GLM, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+	// One column of the pseudo inverse per timepoint
+	for (int t = 0; t < DATA_T; t++)
+	{
+		WhitenedDesignMatrixRow(row, X_GLM, t, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+		if (solved)
+		{
+			SolveWhitenedNormalEquations(L, scale, row, NUMBER_OF_REGRESSORS);
+		}
+
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			xtxxt[r * DATA_T + t] = solved ? row[r] : 0.0f;
+		}
+	}
+}
+
+// Saves the whitened design matrix, and calculates the scalars c^T (X^T X)^-1 c for all contrasts
+__kernel void WhitenDesignMatricesTTest(__global float* X_GLM_Whitened,
+                                        __global float* GLM_Scalars,
+                                        __global const float* X_GLM,
+                                        __global const float* Contrasts,
+                                        __global const float* AR1_Estimates,
+                                        __global const float* AR2_Estimates,
+                                        __global const float* AR3_Estimates,
+                                        __global const float* AR4_Estimates,
+                                        __global const float* Mask,
+                                        __global const float* Voxel_Numbers,
+                                        __private int DATA_W,
+                                        __private int DATA_H,
+                                        __private int DATA_D,
+                                        __private int DATA_T,
+                                        __private int NUMBER_OF_REGRESSORS,
+                                        __private int NUMBER_OF_INVALID_TIMEPOINTS,
+                                        __private int NUMBER_OF_CONTRASTS,
+                                        __private int SLICE,
+                                        __constant float* c_Censored_Timepoints)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int idx = Calculate3DIndex(x,y,z + SLICE,DATA_W,DATA_H);
+
+	if ( Mask[idx] != 1.0f )
+		return;
+
+	int out_idx = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+	int voxel_number = (int)Voxel_Numbers[out_idx];
+	__global float* X = &X_GLM_Whitened[voxel_number * NUMBER_OF_REGRESSORS * DATA_T];
+
+	float AR1 = AR1_Estimates[idx];
+	float AR2 = AR2_Estimates[idx];
+	float AR3 = AR3_Estimates[idx];
+	float AR4 = AR4_Estimates[idx];
+
+	float L[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float scale[MAX_BATCHED_SOLVER_SIZE];
+	float row[MAX_BATCHED_SOLVER_SIZE];
+
+	int solved = FactorizeWhitenedNormalEquations(L, scale, X_GLM, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+	for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+	{
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			row[r] = Contrasts[NUMBER_OF_REGRESSORS * c + r];
+		}
+
+		float scalar = 0.0f;
+		if (solved)
+		{
+			SolveWhitenedNormalEquations(L, scale, row, NUMBER_OF_REGRESSORS);
+			for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+			{
+				scalar += Contrasts[NUMBER_OF_REGRESSORS * c + r] * row[r];
+			}
+		}
+
+		GLM_Scalars[out_idx + c * DATA_W * DATA_H * DATA_D] = scalar;
+	}
+
+	for (int t = 0; t < DATA_T; t++)
+	{
+		WhitenedDesignMatrixRow(row, X_GLM, t, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			X[r * DATA_T + t] = row[r];
+		}
+	}
+}
+
+// Saves the whitened design matrix, and calculates the matrix (C (X^T X)^-1 C^T)^-1 for the F-test
+__kernel void WhitenDesignMatricesFTest(__global float* X_GLM_Whitened,
+                                        __global float* GLM_Scalars,
+                                        __global const float* X_GLM,
+                                        __global const float* Contrasts,
+                                        __global const float* AR1_Estimates,
+                                        __global const float* AR2_Estimates,
+                                        __global const float* AR3_Estimates,
+                                        __global const float* AR4_Estimates,
+                                        __global const float* Mask,
+                                        __global const float* Voxel_Numbers,
+                                        __private int DATA_W,
+                                        __private int DATA_H,
+                                        __private int DATA_D,
+                                        __private int DATA_T,
+                                        __private int NUMBER_OF_REGRESSORS,
+                                        __private int NUMBER_OF_INVALID_TIMEPOINTS,
+                                        __private int NUMBER_OF_CONTRASTS,
+                                        __private int SLICE,
+                                        __constant float* c_Censored_Timepoints)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int idx = Calculate3DIndex(x,y,z + SLICE,DATA_W,DATA_H);
+
+	if ( Mask[idx] != 1.0f )
+		return;
+
+	int out_idx = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+	int voxel_number = (int)Voxel_Numbers[out_idx];
+	__global float* X = &X_GLM_Whitened[voxel_number * NUMBER_OF_REGRESSORS * DATA_T];
+
+	float AR1 = AR1_Estimates[idx];
+	float AR2 = AR2_Estimates[idx];
+	float AR3 = AR3_Estimates[idx];
+	float AR4 = AR4_Estimates[idx];
+
+	float L[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float ctxtxc[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float scale[MAX_BATCHED_SOLVER_SIZE];
+	float row[MAX_BATCHED_SOLVER_SIZE];
+
+	int solved = FactorizeWhitenedNormalEquations(L, scale, X_GLM, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+	// C (X^T X)^-1 C^T, one row at a time
+	if (solved)
+	{
+		for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+		{
+			for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+			{
+				row[r] = Contrasts[NUMBER_OF_REGRESSORS * c + r];
+			}
+
+			SolveWhitenedNormalEquations(L, scale, row, NUMBER_OF_REGRESSORS);
+
+			for (int cc = 0; cc <= c; cc++)
+			{
+				float value = 0.0f;
+				for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+				{
+					value += Contrasts[NUMBER_OF_REGRESSORS * cc + r] * row[r];
+				}
+				ctxtxc[PackedIndex(c,cc)] = value;
+			}
+		}
+
+		solved = CholeskyFactorize(ctxtxc, NUMBER_OF_CONTRASTS);
+	}
+
+	// Invert, one column at a time
+	for (int cc = 0; cc < NUMBER_OF_CONTRASTS; cc++)
+	{
+		for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+		{
+			row[c] = (c == cc) ? 1.0f : 0.0f;
+		}
+
+		if (solved)
+		{
+			CholeskySolve(ctxtxc, row, NUMBER_OF_CONTRASTS);
+		}
+
+		for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+		{
+			GLM_Scalars[out_idx + (cc + c * NUMBER_OF_CONTRASTS) * DATA_W * DATA_H * DATA_D] = solved ? row[c] : 0.0f;
+		}
+	}
+
+	for (int t = 0; t < DATA_T; t++)
+	{
+		WhitenedDesignMatrixRow(row, X_GLM, t, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			X[r * DATA_T + t] = row[r];
+		}
+	}
+}
+
+
+// The kernels below are used for multi-run first level analysis, where the runs are streamed through the device one at a time.
+// The normal equations of each brain voxel are summed over the runs, and are stored in the storage format of the batched solvers
+// with the voxel number as system number. X^T X is stored in Normal_Matrices (only the lower triangle), and the right hand sides
+// are X^T y followed by the contrast vectors, such that the solutions are the beta weights and (X^T X)^-1 c for each contrast.
+// y^T y is stored in Sums_Of_Squares.
+
+// Adds the whitened normal equations of one run, each run is whitened with its own AR parameters and lags do not cross the run start
+__kernel void AccumulateWhitenedNormalEquations(__global float* Normal_Matrices,
+                                                __global float* Right_Hand_Sides,
+                                                __global float* Sums_Of_Squares,
+                                                __global const float* Volumes,
+                                                __global const float* X_GLM,
+                                                __global const float* AR1_Estimates,
+                                                __global const float* AR2_Estimates,
+                                                __global const float* AR3_Estimates,
+                                                __global const float* AR4_Estimates,
+                                                __global const float* Mask,
+                                                __global const float* Voxel_Numbers,
+                                                __constant float* c_Contrasts,
+                                                __private int DATA_W,
+                                                __private int DATA_H,
+                                                __private int DATA_D,
+                                                __private int DATA_T,
+                                                __private int NUMBER_OF_REGRESSORS,
+                                                __private int NUMBER_OF_CONTRASTS,
+                                                __private int NUMBER_OF_INVALID_TIMEPOINTS,
+                                                __private int NUMBER_OF_SYSTEMS,
+                                                __constant float* c_Censored_Timepoints)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int idx = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+
+	if ( Mask[idx] != 1.0f )
+		return;
+
+	int packed_size = PackedIndex(NUMBER_OF_REGRESSORS,0);
+	int s = (int)Voxel_Numbers[idx];
+
+	float AR1 = AR1_Estimates[idx];
+	float AR2 = AR2_Estimates[idx];
+	float AR3 = AR3_Estimates[idx];
+	float AR4 = AR4_Estimates[idx];
+
+	float xtx[MAX_BATCHED_SOLVER_PACKED_SIZE];
+	float xty[MAX_BATCHED_SOLVER_SIZE];
+	float row[MAX_BATCHED_SOLVER_SIZE];
+	float yty = 0.0f;
+
+	for (int i = 0; i < packed_size; i++)
+	{
+		xtx[i] = 0.0f;
+	}
+
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		xty[r] = 0.0f;
+	}
+
+	// Same whitening of the data as in ApplyWhiteningAR4, censored timepoints are set to zero
+	float old_value_1 = 0.0f, old_value_2 = 0.0f, old_value_3 = 0.0f, old_value_4 = 0.0f;
+
+	for (int t = 0; t < DATA_T; t++)
+	{
+		float value = c_Censored_Timepoints[t] * Volumes[Calculate4DIndex(x,y,z,t,DATA_W,DATA_H,DATA_D)];
+		float whitened_value = value - AR1 * old_value_1 - AR2 * old_value_2 - AR3 * old_value_3 - AR4 * old_value_4;
+
+		old_value_4 = old_value_3;
+		old_value_3 = old_value_2;
+		old_value_2 = old_value_1;
+		old_value_1 = value;
+
+		if ( (t < NUMBER_OF_INVALID_TIMEPOINTS) || (c_Censored_Timepoints[t] == 0.0f) )
+			continue;
+
+		WhitenedDesignMatrixRow(row, X_GLM, t, AR1, AR2, AR3, AR4, DATA_T, NUMBER_OF_REGRESSORS, NUMBER_OF_INVALID_TIMEPOINTS, c_Censored_Timepoints);
+
+		for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+		{
+			for (int j = 0; j <= i; j++)
+			{
+				xtx[PackedIndex(i,j)] += row[i] * row[j];
+			}
+			xty[i] += row[i] * whitened_value;
+		}
+		yty += whitened_value * whitened_value;
+	}
+
+	for (int i = 0; i < NUMBER_OF_REGRESSORS; i++)
+	{
+		for (int j = 0; j <= i; j++)
+		{
+			Normal_Matrices[s + (i + j * NUMBER_OF_REGRESSORS) * NUMBER_OF_SYSTEMS] += xtx[PackedIndex(i,j)];
+		}
+	}
+
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		Right_Hand_Sides[s + r * NUMBER_OF_SYSTEMS] += xty[r];
+	}
+
+	// The contrast vectors are the same for all runs, and are written rather than added
+	for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+	{
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			Right_Hand_Sides[s + (r + (c + 1) * NUMBER_OF_REGRESSORS) * NUMBER_OF_SYSTEMS] = c_Contrasts[NUMBER_OF_REGRESSORS * c + r];
+		}
+	}
+
+	Sums_Of_Squares[s] += yty;
+}
+
+// Calculates contrasts, residual variances and t-values from the solutions of the summed normal equations
+// The residual sum of squares is y^T y - b^T X^T y, which does not require another pass over the data
+__kernel void CalculateStatisticalMapsGLMTTestNormalEquations(__global float* Beta_Volumes,
+                                                              __global float* Contrast_Volumes,
+                                                              __global float* Statistical_Maps,
+                                                              __global float* Residual_Variances,
+                                                              __global const float* Solutions,
+                                                              __global const int* Status,
+                                                              __global const float* Right_Hand_Sides,
+                                                              __global const float* Sums_Of_Squares,
+                                                              __global const float* Mask,
+                                                              __global const float* Voxel_Numbers,
+                                                              __constant float* c_Contrasts,
+                                                              __private int DATA_W,
+                                                              __private int DATA_H,
+                                                              __private int DATA_D,
+                                                              __private int NUMBER_OF_REGRESSORS,
+                                                              __private int NUMBER_OF_CONTRASTS,
+                                                              __private int NUMBER_OF_SYSTEMS,
+                                                              __private float DEGREES_OF_FREEDOM)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	int idx = Calculate3DIndex(x,y,z,DATA_W,DATA_H);
+
+	if ( Mask[idx] != 1.0f )
+	{
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			Beta_Volumes[Calculate4DIndex(x,y,z,r,DATA_W,DATA_H,DATA_D)] = 0.0f;
+		}
+
+		for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+		{
+			Contrast_Volumes[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = 0.0f;
+			Statistical_Maps[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = 0.0f;
+		}
+
+		Residual_Variances[idx] = 0.0f;
+		return;
+	}
+
+	int s = (int)Voxel_Numbers[idx];
+	int solved = Status[s];
+
+	// Unsolved systems have zero solutions
+	float residual_variance = 0.0f;
+	if (solved)
+	{
+		float rss = Sums_Of_Squares[s];
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			rss -= Solutions[s + r * NUMBER_OF_SYSTEMS] * Right_Hand_Sides[s + r * NUMBER_OF_SYSTEMS];
+		}
+		residual_variance = max(rss, 0.0f) / DEGREES_OF_FREEDOM;
+	}
+
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		Beta_Volumes[Calculate4DIndex(x,y,z,r,DATA_W,DATA_H,DATA_D)] = Solutions[s + r * NUMBER_OF_SYSTEMS];
+	}
+
+	Residual_Variances[idx] = residual_variance;
+
+	for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+	{
+		float contrast_value = 0.0f;
+		float scalar = 0.0f;
+
+		// c^T b and c^T (X^T X)^-1 c
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			float contrast = c_Contrasts[NUMBER_OF_REGRESSORS * c + r];
+			contrast_value += contrast * Solutions[s + r * NUMBER_OF_SYSTEMS];
+			scalar += contrast * Solutions[s + (r + (c + 1) * NUMBER_OF_REGRESSORS) * NUMBER_OF_SYSTEMS];
+		}
+
+		Contrast_Volumes[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = contrast_value;
+		Statistical_Maps[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = ((residual_variance * scalar) > 0.0f) ? contrast_value * rsqrt(residual_variance * scalar) : 0.0f;
+	}
+}
@@ -861,6 +861,86 @@ __kernel void CalculateGLMResidualsSlice(__global float* Residuals,
 }
 
 
+// Same as CalculateGLMResidualsSlice, but the volumes are stored as the mean of each voxel and the deviations from the mean
+// as half floats, multiplied with a common scale
+__kernel void CalculateGLMResidualsSliceHalf(__global float* Residuals,
+		                                 __global const half* Volumes,
+		                                 __global const float* Means,
+		                                 __global const float* Beta_Volumes,
+		                                 __global const float* Mask,
+		                                 __global const float *c_X_GLM,
+		                                 __private int DATA_W,
+		                                 __private int DATA_H,
+		                                 __private int DATA_D,
+		                                 __private int NUMBER_OF_VOLUMES,
+		                                 __private int NUMBER_OF_REGRESSORS,
+                                         __private int slice,
+                                         __private float inverse_scale)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	int3 tIdx = {get_local_id(0), get_local_id(1), get_local_id(2)};
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)] != 1.0f )
+	{
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = 0.0f;
+		}
+
+		return;
+	}
+
+	int t = 0;
+	float eps, meaneps, vareps;
+	float mean = Means[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)];
+
+	// Special case for low number of regressors, store beta scores in registers for faster performance
+	if (NUMBER_OF_REGRESSORS <= 25)
+	{
+		float beta[25];
+
+		// Load beta values into registers
+	    for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			beta[r] = Beta_Volumes[Calculate4DIndex(x,y,slice,r,DATA_W,DATA_H,DATA_D)];
+		}
+
+		// Calculate the residual
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			eps = mean + inverse_scale * vload_half(Calculate3DIndex(x,y,v,DATA_W,DATA_H), Volumes);
+			for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+			{
+				eps -= c_X_GLM[NUMBER_OF_VOLUMES * r + v] * beta[r];
+			}
+
+			Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;
+		}
+	}
+	// General case for large number of regressors (slower)
+	else
+	{
+		// Calculate the residual
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			eps = mean + inverse_scale * vload_half(Calculate3DIndex(x,y,v,DATA_W,DATA_H), Volumes);
+			for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+			{
+				eps -= c_X_GLM[NUMBER_OF_VOLUMES * r + v] * Beta_Volumes[Calculate4DIndex(x,y,slice,r,DATA_W,DATA_H,DATA_D)];
+			}
+
+			Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;
+		}
+	}
+}
+
+
 
 __kernel void CalculateStatisticalMapsGLMTTestFirstLevel(__global float* Statistical_Maps,
 														 __global float* Contrast_Volumes,
@@ -943,7 +1023,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevel(__global float* Statist
 	
 			Residuals[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)] = eps;		
 		}
-		meaneps /= ((float)NUMBER_OF_VOLUMES);
+		meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 		// Now calculate the variance of eps, using voxel-specific design models
 		vareps = 0.0f;
@@ -958,7 +1038,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevel(__global float* Statist
 			}
 			vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 		}
-		vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+		vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 		Residual_Variances[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = vareps;
 
 		// Loop over contrasts and calculate t-values, using a voxel-specific GLM scalar
@@ -992,7 +1072,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevel(__global float* Statist
 	
 			Residuals[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)] = eps;		
 		}
-		meaneps /= ((float)NUMBER_OF_VOLUMES);
+		meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 		// Now calculate the variance of eps, using voxel-specific design models
 		vareps = 0.0f;
@@ -1007,7 +1087,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevel(__global float* Statist
 			}
 			vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 		}
-		vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+		vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 		Residual_Variances[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = vareps;
 
 		// Loop over contrasts and calculate t-values, using a voxel-specific GLM scalar
@@ -1110,7 +1190,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevelSlice(__global float* St
 	
 			Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;		
 		}
-		meaneps /= ((float)NUMBER_OF_VOLUMES);
+		meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 		// Now calculate the variance of eps, using voxel-specific design models
 		vareps = 0.0f;
@@ -1126,7 +1206,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevelSlice(__global float* St
 			}
 			vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 		}
-		vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+		vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 		Residual_Variances[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)] = vareps;
 
 		// Loop over contrasts and calculate t-values, using a voxel-specific GLM scalar
@@ -1161,7 +1241,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevelSlice(__global float* St
 	
 			Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;		
 		}
-		meaneps /= ((float)NUMBER_OF_VOLUMES);
+		meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 		// Now calculate the variance of eps, using voxel-specific design models
 		vareps = 0.0f;
@@ -1177,7 +1257,7 @@ __kernel void CalculateStatisticalMapsGLMTTestFirstLevelSlice(__global float* St
 			}
 			vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 		}
-		vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+		vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 		Residual_Variances[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)] = vareps;
 
 		// Loop over contrasts and calculate t-values, using a voxel-specific GLM scalar
@@ -1267,8 +1347,7 @@ __kernel void CalculateStatisticalMapsGLMFTestFirstLevel(__global float* Statist
 		meaneps += eps;
 		Residuals[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)] = eps;
 	}
-	//meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
-	meaneps /= ((float)NUMBER_OF_VOLUMES);
+	meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 	// Now calculate the variance of eps, using voxel-specific design models
 	vareps = 0.0f;
@@ -1282,9 +1361,8 @@ __kernel void CalculateStatisticalMapsGLMFTestFirstLevel(__global float* Statist
 		vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 	}
 	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_REGRESSORS - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
-	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_REGRESSORS - 1.0f);
-	vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+	vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 	Residual_Variances[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = vareps;
 
 	// Calculate matrix vector product C*beta (minus u)
@@ -1395,8 +1473,7 @@ __kernel void CalculateStatisticalMapsGLMFTestFirstLevelSlice(__global float* St
 		meaneps += eps;
 		Residuals[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;
 	}
-	//meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
-	meaneps /= ((float)NUMBER_OF_VOLUMES);
+	meaneps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS);
 
 	// Now calculate the variance of eps, using voxel-specific design models
 	vareps = 0.0f;
@@ -1411,9 +1488,8 @@ __kernel void CalculateStatisticalMapsGLMFTestFirstLevelSlice(__global float* St
 		vareps += (eps - meaneps) * (eps - meaneps) * c_Censored_Timepoints[v];
 	}
 	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_REGRESSORS - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
-	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 	//vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_REGRESSORS - 1.0f);
-	vareps /= ((float)NUMBER_OF_VOLUMES - 1.0f);
+	vareps /= ((float)NUMBER_OF_VOLUMES - (float)NUMBER_OF_CENSORED_TIMEPOINTS - 1.0f);
 	Residual_Variances[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)] = vareps;
 
 	// Calculate matrix vector product C*beta (minus u)
@@ -1825,6 +1901,132 @@ __kernel void RemoveLinearFitSlice(__global float* Residual_Volumes,
 	}
 }
 
+// Largest number of nuisance basis vectors, same value as in broccoli_constants.h. The host pads the basis with zero vectors,
+// so the loops over the coefficients have a fixed length and are unrolled, which keeps the coefficients in registers
+#define MAX_NUISANCE_REGRESSORS 128
+
+// Removes the projection onto an orthonormal nuisance basis, r = y - Q Q^T y, in one pass over the data
+// Q is stored time point major, Q[r + v * MAX_NUISANCE_REGRESSORS], so that each time point reads contiguous coefficients
+// No beta volumes are written
+__kernel void RemoveNuisanceRegressors(__global float* Residual_Volumes, 
+                                       __global const float* Volumes, 
+							  		   __global const float* Mask, 
+							  		   __global const float* Q, 
+							  		   __private int DATA_W, 
+							  		   __private int DATA_H, 
+							  		   __private int DATA_D, 
+							  		   __private int NUMBER_OF_VOLUMES)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
+	{
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			Residual_Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)] = 0.0f;
+		}
+
+		return;
+	}
+
+	float eps;
+	float coefficients[MAX_NUISANCE_REGRESSORS];
+
+	#pragma unroll
+	for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+	{
+		coefficients[r] = 0.0f;
+	}
+
+	// Project the time series onto the basis
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		#pragma unroll
+		for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+		{
+			coefficients[r] += Q[r + v * MAX_NUISANCE_REGRESSORS] * value;
+		}
+	}
+
+	// Calculate the residual
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		eps = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		#pragma unroll
+		for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+		{
+			eps -= coefficients[r] * Q[r + v * MAX_NUISANCE_REGRESSORS];
+		}
+		Residual_Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)] = eps;
+	}
+}
+
+__kernel void RemoveNuisanceRegressorsSlice(__global float* Residual_Volumes, 
+                                            __global const float* Volumes, 
+							  		        __global const float* Mask, 
+							  		        __global const float* Q, 
+							  		        __private int DATA_W, 
+							  		        __private int DATA_H, 
+							  		        __private int DATA_D, 
+							  		        __private int NUMBER_OF_VOLUMES, 
+							  		        __private int slice)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,slice,DATA_W,DATA_H)] != 1.0f )
+	{
+		for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+		{
+			Residual_Volumes[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = 0.0f;
+		}
+
+		return;
+	}
+
+	float eps;
+	float coefficients[MAX_NUISANCE_REGRESSORS];
+
+	#pragma unroll
+	for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+	{
+		coefficients[r] = 0.0f;
+	}
+
+	// Project the time series onto the basis
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[Calculate3DIndex(x,y,v,DATA_W,DATA_H)];
+		#pragma unroll
+		for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+		{
+			coefficients[r] += Q[r + v * MAX_NUISANCE_REGRESSORS] * value;
+		}
+	}
+
+	// Calculate the residual
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		eps = Volumes[Calculate3DIndex(x,y,v,DATA_W,DATA_H)];
+		#pragma unroll
+		for (int r = 0; r < MAX_NUISANCE_REGRESSORS; r++)
+		{
+			eps -= coefficients[r] * Q[r + v * MAX_NUISANCE_REGRESSORS];
+		}
+		Residual_Volumes[Calculate3DIndex(x,y,v,DATA_W,DATA_H)] = eps;
+	}
+}
+
 
 
 
@@ -23,6 +23,9 @@
     DEALINGS IN THE SOFTWARE.
 */
 
+// Same value as in broccoli_constants.h
+#define MAX_BATCHED_CONTRAST_VALUES 64
+
 // Help functions
 int Calculate2DIndex(int x, int y, int DATA_W)
 {
@@ -1668,7 +1671,180 @@ __kernel void CalculateStatisticalMapsGLMTTestSecondLevelPermutation(__global fl
 	Statistical_Maps[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = contrast_value * rsqrt(vareps * c_ctxtxc_GLM[contrast]);
 }
 
+// Calculates the residual sum of squares of the nuisance model of each contrast, used by the batched permutation test.
+// Null_Bases contains an orthonormal basis of the nuisance regressors for each contrast, zero padded to the same number of columns
+__kernel void CalculateNuisanceResidualSumsOfSquaresSecondLevel(__global float* Residual_Sums,
+		                                                        __global const float* Volumes,
+		                                                        __global const float* Mask,
+		                                                        __global const float* Null_Bases,
+		                                                        __private int DATA_W,
+		                                                        __private int DATA_H,
+		                                                        __private int DATA_D,
+		                                                        __private int NUMBER_OF_VOLUMES,
+		                                                        __private int NUMBER_OF_BASIS_VECTORS,
+		                                                        __private int NUMBER_OF_CONTRASTS)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
+		return;
+
+	float sumOfSquares = 0.0f;
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		sumOfSquares += value * value;
+	}
+
+	for (int c = 0; c < NUMBER_OF_CONTRASTS; c++)
+	{
+		float residualSum = sumOfSquares;
+		for (int k = 0; k < NUMBER_OF_BASIS_VECTORS; k++)
+		{
+			float projection = 0.0f;
+			for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+			{
+				projection += Null_Bases[v + k * NUMBER_OF_VOLUMES + c * NUMBER_OF_VOLUMES * NUMBER_OF_BASIS_VECTORS] * Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+			}
+			residualSum -= projection * projection;
+		}
+		Residual_Sums[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = residualSum;
+	}
+}
+
+// Calculates t-maps for a batch of contrasts and one permutation, reading each data vector only once.
+// Permuted_Designs contains the permuted design matrix after removing the nuisance regressors of each contrast,
+// stored as NUMBER_OF_VOLUMES rows of NUMBER_OF_CONTRASTS_IN_BATCH * NUMBER_OF_REGRESSORS values, zero padded to MAX_BATCHED_CONTRAST_VALUES.
+// Since the nuisance projection is symmetric and idempotent, this gives the same t-values as
+// CalculateStatisticalMapsGLMTTestSecondLevelPermutation applied to data transformed for each contrast
+__kernel void CalculateStatisticalMapsGLMTTestSecondLevelPermutationBatched(__global float* Statistical_Maps,
+		                                                                    __global const float* Volumes,
+		                                                                    __global const float* Mask,
+		                                                                    __global const float* Residual_Sums,
+		                                                                    __global const float* Permuted_Designs,
+		                                                                    __constant float* c_xtx_GLM,
+		                                                                    __constant float* c_Contrasts,
+		                                                                    __constant float* c_ctxtxc_GLM,
+		                                                                    __private int DATA_W,
+		                                                                    __private int DATA_H,
+		                                                                    __private int DATA_D,
+		                                                                    __private int NUMBER_OF_VOLUMES,
+		                                                                    __private int NUMBER_OF_REGRESSORS,
+		                                                                    __private int FIRST_CONTRAST,
+		                                                                    __private int NUMBER_OF_CONTRASTS_IN_BATCH)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
+		return;
+
+	// Scalar products between the data and the permuted designs of all contrasts in the batch
+	float xty[MAX_BATCHED_CONTRAST_VALUES];
+
+	#pragma unroll
+	for (int i = 0; i < MAX_BATCHED_CONTRAST_VALUES; i++)
+	{
+		xty[i] = 0.0f;
+	}
+
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		#pragma unroll
+		for (int i = 0; i < MAX_BATCHED_CONTRAST_VALUES; i++)
+		{
+			xty[i] += Permuted_Designs[i + v * MAX_BATCHED_CONTRAST_VALUES] * value;
+		}
+	}
+
+	for (int b = 0; b < NUMBER_OF_CONTRASTS_IN_BATCH; b++)
+	{
+		int c = FIRST_CONTRAST + b;
+
+		// Contrast value c^T (X^T X)^(-1) X^T y and explained sum of squares y^T X (X^T X)^(-1) X^T y
+		float contrast_value = 0.0f;
+		float explained = 0.0f;
+		for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+		{
+			float beta = 0.0f;
+			for (int s = 0; s < NUMBER_OF_REGRESSORS; s++)
+			{
+				beta += c_xtx_GLM[s + r * NUMBER_OF_REGRESSORS] * xty[s + b * NUMBER_OF_REGRESSORS];
+			}
+			contrast_value += c_Contrasts[r + c * NUMBER_OF_REGRESSORS] * beta;
+			explained += xty[r + b * NUMBER_OF_REGRESSORS] * beta;
+		}
+
+		float vareps = (Residual_Sums[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] - explained) / ((float)NUMBER_OF_VOLUMES - NUMBER_OF_REGRESSORS);
+		Statistical_Maps[Calculate4DIndex(x,y,z,c,DATA_W,DATA_H,DATA_D)] = contrast_value * rsqrt(vareps * c_ctxtxc_GLM[c]);
+	}
+}
+
+// Calculates a statistical map for second level analysis when the subjects belong to different variance groups.
+// The contrast value is divided by its standard error with one residual variance per variance group (Welch / G-statistic),
+// c_Variance_Weights contains (sum of the squared contrast weights of the group) / (residual degrees of freedom of the group) for each subject,
+// calculated on the host for the current permutation. With a single variance group this is the ordinary t-value
+__kernel void CalculateStatisticalMapsGLMWelchSecondLevelPermutation(__global float* Statistical_Maps,
+		                                       	   	   				 __global const float* Volumes,
+		                                       	   	   				 __global const float* Mask,
+		                                       	   	   				 __constant float* c_X_GLM,
+		                                       	   	   				 __constant float* c_xtxxt_GLM,
+		                                       	   	   				 __constant float* c_Contrasts,
+		                                       	   	   				 __constant float* c_Variance_Weights,
+		                                       	   	   				 __constant unsigned short int* c_Permutation_Vector,
+		                                       	   	   				 __private int DATA_W,
+		                                       	   	   				 __private int DATA_H,
+		                                       	   	   				 __private int DATA_D,
+		                                       	   	   				 __private int NUMBER_OF_VOLUMES,
+		                                       	   	   				 __private int NUMBER_OF_REGRESSORS,
+																	 __private int contrast,
+																	 __private int STATISTICAL_MAP)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+	int z = get_global_id(2);
+
+	if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+		return;
+
+	if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
+		return;
 
+	float eps, vareps;
+	float beta[25];
 
+	for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+	{
+		beta[r] = 0.0f;
+	}
 
+	// Calculate betahat, i.e. multiply (x^T x)^(-1) x^T with Y
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		float value = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		CalculateBetaWeightsSecondLevel(beta, value, c_xtxxt_GLM, v, c_Permutation_Vector, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+	}
+
+	// Variance of the contrast value, sum over the variance groups
+	vareps = 0.0f;
+	for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+	{
+		eps = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+		eps = CalculateEpsSecondLevel(eps, beta, c_X_GLM, v, c_Permutation_Vector, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+		vareps += c_Variance_Weights[v] * eps * eps;
+	}
+
+	float contrast_value = CalculateContrastValue(beta, c_Contrasts, contrast, NUMBER_OF_REGRESSORS);
+	Statistical_Maps[Calculate4DIndex(x,y,z,STATISTICAL_MAP,DATA_W,DATA_H,DATA_D)] = contrast_value * rsqrt(vareps);
+}
 
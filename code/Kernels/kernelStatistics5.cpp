@@ -1940,97 +1940,191 @@ float CalculateFTestScalar(__private float* cbeta, __private float* beta, int NU
 
 
 
-__kernel void CalculateStatisticalMapsGLMFTestFirstLevelPermutation(__global float* Statistical_Maps,
-                                                                    __global const float* Volumes,
-                                                                    __global const float* Mask,
-                                                                    __constant float* c_X_GLM,
-                                                                    __constant float* c_xtxxt_GLM,
-                                                                    __constant float* c_Contrasts,
-                                                                    __constant float* c_ctxtxc_GLM,
-                                                                    __private int DATA_W,
-                                                                    __private int DATA_H,
-                                                                    __private int DATA_D,
-                                                                    __private int NUMBER_OF_VOLUMES,
-                                                                    __private int NUMBER_OF_REGRESSORS,
-                                                                    __private int NUMBER_OF_CONTRASTS)
+// Residual variance for the permutation kernels below, calculated from sums collected in one pass over the data,
+// eps^T eps = y^T y - beta^T X^T y and sum(eps) = sum(y) - sum(X beta)
+float CalculateResidualVarianceFirstLevel(__private float* beta,
+                                          __private float* xty,
+                                          float sum_y,
+                                          float sum_yy,
+                                          __constant float* c_X_GLM,
+                                          int NUMBER_OF_VOLUMES,
+                                          int NUMBER_OF_REGRESSORS)
+{
+    float sum_eps = sum_y;
+    float sum_epseps = sum_yy;
+    
+    for (int r = 0; r < NUMBER_OF_REGRESSORS; r++)
+    {
+        sum_epseps -= beta[r] * xty[r];
+    }
+    
+    for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
+    {
+        sum_eps = CalculateEpsFirstLevel(sum_eps, beta, c_X_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+    }
+    
+    float n = (float)NUMBER_OF_VOLUMES;
+    return max((sum_epseps - sum_eps * sum_eps / n) / (n - 1.0f), 0.0f);
+}
+
+// Calculates a statistical map for one permutation of the whitened data, the permuted and inverse whitened timeseries
+// is generated in registers and never stored, and the whitened volumes are only read once
+// The permutation vectors are stored as a block in global memory, permutation is the index in the block
+__kernel void CalculateStatisticalMapsGLMFTestFirstLevelPermutationFused(__global float* Statistical_Maps,
+                                                                         __global const float* Whitened_Volumes,
+                                                                         __global const float* AR1_Estimates,
+                                                                         __global const float* AR2_Estimates,
+                                                                         __global const float* AR3_Estimates,
+                                                                         __global const float* AR4_Estimates,
+                                                                         __global const float* Mask,
+                                                                         __global const unsigned short int* Permutation_Vectors,
+                                                                         __constant float* c_X_GLM,
+                                                                         __constant float* c_xtxxt_GLM,
+                                                                         __constant float* c_Contrasts,
+                                                                         __constant float* c_ctxtxc_GLM,
+                                                                         __private int DATA_W,
+                                                                         __private int DATA_H,
+                                                                         __private int DATA_D,
+                                                                         __private int NUMBER_OF_VOLUMES,
+                                                                         __private int NUMBER_OF_REGRESSORS,
+                                                                         __private int NUMBER_OF_CONTRASTS,
+                                                                         __private int permutation)
 {
     int x = get_global_id(0);
     int y = get_global_id(1);
     int z = get_global_id(2);
     
-    int3 tIdx = {get_local_id(0), get_local_id(1), get_local_id(2)};
-    
     if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
         return;
     
     if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
         return;
     
-    int t = 0;
-    float eps, meaneps, vareps;
+    float4 alphas;
+    alphas.x = AR1_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.y = AR2_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.z = AR3_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.w = AR4_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    
+    __global const unsigned short int* permutation_vector = &Permutation_Vectors[permutation * NUMBER_OF_VOLUMES];
+    
     float beta[25];
+    float xty[25];
+    for (int r = 0; r < 25; r++)
+    {
+        beta[r] = 0.0f;
+        xty[r] = 0.0f;
+    }
     
-    // Reset beta weights
-    beta[0] = 0.0f;
-    beta[1] = 0.0f;
-    beta[2] = 0.0f;
-    beta[3] = 0.0f;
-    beta[4] = 0.0f;
-    beta[5] = 0.0f;
-    beta[6] = 0.0f;
-    beta[7] = 0.0f;
-    beta[8] = 0.0f;
-    beta[9] = 0.0f;
-    beta[10] = 0.0f;
-    beta[11] = 0.0f;
-    beta[12] = 0.0f;
-    beta[13] = 0.0f;
-    beta[14] = 0.0f;
-    beta[15] = 0.0f;
-    beta[16] = 0.0f;
-    beta[17] = 0.0f;
-    beta[18] = 0.0f;
-    beta[19] = 0.0f;
-    beta[20] = 0.0f;
-    beta[21] = 0.0f;
-    beta[22] = 0.0f;
-    beta[23] = 0.0f;
-    beta[24] = 0.0f;
+    float sum_y = 0.0f;
+    float sum_yy = 0.0f;
+    float old_value_1 = 0.0f, old_value_2 = 0.0f, old_value_3 = 0.0f, old_value_4 = 0.0f;
     
-    // Calculate betahat, i.e. multiply (x^T x)^(-1) x^T with Y
-    // Loop over volumes
+    // Read the data in a permuted order, apply an inverse whitening transform, and calculate betahat and X^T y
     for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
     {
-        float value = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
+        float value = alphas.x * old_value_4 + alphas.y * old_value_3 + alphas.z * old_value_2 + alphas.w * old_value_1 + Whitened_Volumes[Calculate4DIndex(x,y,z,permutation_vector[v],DATA_W,DATA_H,DATA_D)];
+        
+        old_value_1 = old_value_2;
+        old_value_2 = old_value_3;
+        old_value_3 = old_value_4;
+        old_value_4 = value;
         
-        // Loop over regressors using unrolled code for performance
         CalculateBetaWeightsFirstLevel(beta, value, c_xtxxt_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+        CalculateBetaWeightsFirstLevel(xty, value, c_X_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+        sum_y += value;
+        sum_yy += value * value;
+    }
+    
+    float vareps = CalculateResidualVarianceFirstLevel(beta, xty, sum_y, sum_yy, c_X_GLM, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+    
+    // Calculate matrix vector product C*beta (minus u)
+    float cbeta[10];
+    CalculateCBetas(cbeta, beta, c_Contrasts, NUMBER_OF_REGRESSORS, NUMBER_OF_CONTRASTS);
+    
+    // Calculate right hand side, temp = ( 1/vareps * (C^T (X^T X)^(-1) C^T)^(-1) ) (C*beta)
+    CalculateCTXTXCCBetas(beta, vareps, c_ctxtxc_GLM, cbeta, NUMBER_OF_CONTRASTS);
+    
+    // Finally calculate (C*beta)^T * temp
+    float scalar = CalculateFTestScalar(cbeta,beta,NUMBER_OF_CONTRASTS);
+    
+    // Save F-value
+    Statistical_Maps[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = scalar/(float)NUMBER_OF_CONTRASTS;
+}
+
+// Same as CalculateStatisticalMapsGLMFTestFirstLevelPermutationFused, but the whitened volumes are stored as half floats
+__kernel void CalculateStatisticalMapsGLMFTestFirstLevelPermutationFusedHalf(__global float* Statistical_Maps,
+                                                                             __global const half* Whitened_Volumes,
+                                                                             __global const float* AR1_Estimates,
+                                                                             __global const float* AR2_Estimates,
+                                                                             __global const float* AR3_Estimates,
+                                                                             __global const float* AR4_Estimates,
+                                                                             __global const float* Mask,
+                                                                             __global const unsigned short int* Permutation_Vectors,
+                                                                             __constant float* c_X_GLM,
+                                                                             __constant float* c_xtxxt_GLM,
+                                                                             __constant float* c_Contrasts,
+                                                                             __constant float* c_ctxtxc_GLM,
+                                                                             __private int DATA_W,
+                                                                             __private int DATA_H,
+                                                                             __private int DATA_D,
+                                                                             __private int NUMBER_OF_VOLUMES,
+                                                                             __private int NUMBER_OF_REGRESSORS,
+                                                                             __private int NUMBER_OF_CONTRASTS,
+                                                                             __private int permutation)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    int z = get_global_id(2);
+    
+    if (x >= DATA_W || y >= DATA_H || z >= DATA_D)
+        return;
+    
+    if ( Mask[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] != 1.0f )
+        return;
+    
+    float4 alphas;
+    alphas.x = AR1_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.y = AR2_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.z = AR3_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    alphas.w = AR4_Estimates[Calculate3DIndex(x,y,z,DATA_W,DATA_H)];
+    
+    __global const unsigned short int* permutation_vector = &Permutation_Vectors[permutation * NUMBER_OF_VOLUMES];
+    
+    float beta[25];
+    float xty[25];
+    for (int r = 0; r < 25; r++)
+    {
+        beta[r] = 0.0f;
+        xty[r] = 0.0f;
     }
     
-    // Calculate the mean and variance of the error eps
-    meaneps = 0.0f;
-    vareps = 0.0f;
-    float n = 0.0f;
+    float sum_y = 0.0f;
+    float sum_yy = 0.0f;
+    float old_value_1 = 0.0f, old_value_2 = 0.0f, old_value_3 = 0.0f, old_value_4 = 0.0f;
+    
+    // Read the data in a permuted order, apply an inverse whitening transform, and calculate betahat and X^T y
     for (int v = 0; v < NUMBER_OF_VOLUMES; v++)
     {
-        eps = Volumes[Calculate4DIndex(x,y,z,v,DATA_W,DATA_H,DATA_D)];
-        eps = CalculateEpsFirstLevel(eps, beta, c_X_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+        float value = alphas.x * old_value_4 + alphas.y * old_value_3 + alphas.z * old_value_2 + alphas.w * old_value_1 + vload_half(Calculate4DIndex(x,y,z,permutation_vector[v],DATA_W,DATA_H,DATA_D),Whitened_Volumes);
+        
+        old_value_1 = old_value_2;
+        old_value_2 = old_value_3;
+        old_value_3 = old_value_4;
+        old_value_4 = value;
         
-        n += 1.0f;
-        float delta = eps - meaneps;
-        meaneps += delta/n;
-        vareps += delta * (eps - meaneps);
+        CalculateBetaWeightsFirstLevel(beta, value, c_xtxxt_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+        CalculateBetaWeightsFirstLevel(xty, value, c_X_GLM, v, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
+        sum_y += value;
+        sum_yy += value * value;
     }
-    vareps = vareps / (n - 1.0f);
     
-    //-------------------------
+    float vareps = CalculateResidualVarianceFirstLevel(beta, xty, sum_y, sum_yy, c_X_GLM, NUMBER_OF_VOLUMES, NUMBER_OF_REGRESSORS);
     
     // Calculate matrix vector product C*beta (minus u)
     float cbeta[10];
     CalculateCBetas(cbeta, beta, c_Contrasts, NUMBER_OF_REGRESSORS, NUMBER_OF_CONTRASTS);
     
-    // Calculate total vector matrix vector product (C*beta)^T ( 1/vareps * (C^T (X^T X)^(-1) C^T)^(-1) ) (C*beta)
-    
     // Calculate right hand side, temp = ( 1/vareps * (C^T (X^T X)^(-1) C^T)^(-1) ) (C*beta)
     CalculateCTXTXCCBetas(beta, vareps, c_ctxtxc_GLM, cbeta, NUMBER_OF_CONTRASTS);
     
@@ -2040,4 +2134,3 @@ __kernel void CalculateStatisticalMapsGLMFTestFirstLevelPermutation(__global flo
     // Save F-value
     Statistical_Maps[Calculate3DIndex(x,y,z,DATA_W,DATA_H)] = scalar/(float)NUMBER_OF_CONTRASTS;
 }
-
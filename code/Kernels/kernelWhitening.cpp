@@ -99,7 +99,7 @@ void Invert_4x4(float Cxx[4][4], float inv_Cxx[4][4])
 
 
 
-// Estimates voxel specific AR(4) models
+// Estimates voxel specific AR(4) models, censored timepoints (weight 0 in c_Censored_Timepoints) are left out
 __kernel void EstimateAR4Models(__global float* AR1_Estimates, 
                                 __global float* AR2_Estimates, 
 								__global float* AR3_Estimates, 
@@ -110,7 +110,8 @@ __kernel void EstimateAR4Models(__global float* AR1_Estimates,
 								__private int DATA_H, 
 								__private int DATA_D, 
 								__private int DATA_T,
-								__private int INVALID_TIMEPOINTS)
+								__private int INVALID_TIMEPOINTS,
+								__constant float* c_Censored_Timepoints)
 {
 	int x = get_global_id(0);
 	int y = get_global_id(1);
@@ -130,34 +131,27 @@ __kernel void EstimateAR4Models(__global float* AR1_Estimates,
 	}
 
     int t = 0;
-	float old_value_1, old_value_2, old_value_3, old_value_4, old_value_5;
+	float old_value_1 = 0.0f, old_value_2 = 0.0f, old_value_3 = 0.0f, old_value_4 = 0.0f, old_value_5;
+	float old_weight_1 = 0.0f, old_weight_2 = 0.0f, old_weight_3 = 0.0f, old_weight_4 = 0.0f, old_weight_5;
 	float c0 = 0.0f;
     float c1 = 0.0f;
     float c2 = 0.0f;
     float c3 = 0.0f;
     float c4 = 0.0f;
-
-    old_value_1 = fMRI_Volumes[Calculate4DIndex(x, y, z, 0 + INVALID_TIMEPOINTS, DATA_W, DATA_H, DATA_D)];
-	c0 += old_value_1 * old_value_1;
-    old_value_2 = fMRI_Volumes[Calculate4DIndex(x, y, z, 1 + INVALID_TIMEPOINTS, DATA_W, DATA_H, DATA_D)];
-	c0 += old_value_2 * old_value_2;
-    c1 += old_value_2 * old_value_1;
-    old_value_3 = fMRI_Volumes[Calculate4DIndex(x, y, z, 2 + INVALID_TIMEPOINTS, DATA_W, DATA_H, DATA_D)];
-	c0 += old_value_3 * old_value_3;
-    c1 += old_value_3 * old_value_2;
-    c2 += old_value_3 * old_value_1;
-    old_value_4 = fMRI_Volumes[Calculate4DIndex(x, y, z, 3 + INVALID_TIMEPOINTS, DATA_W, DATA_H, DATA_D)];
-	c0 += old_value_4 * old_value_4;
-    c1 += old_value_4 * old_value_3;
-    c2 += old_value_4 * old_value_2;
-    c3 += old_value_4 * old_value_1;
-
-    // Estimate c0, c1, c2, c3, c4
-    for (t = 4 + INVALID_TIMEPOINTS; t < DATA_T; t++)
+	float n0 = 0.0f;
+    float n1 = 0.0f;
+    float n2 = 0.0f;
+    float n3 = 0.0f;
+    float n4 = 0.0f;
+
+    // Estimate c0, c1, c2, c3, c4, censored timepoints are set to zero and the sums
+    // are normalized with the number of valid pairs of timepoints for each lag
+    for (t = INVALID_TIMEPOINTS; t < DATA_T; t++)
     {
         // Read data into register
-        old_value_5 = fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)];
-		
+        old_weight_5 = c_Censored_Timepoints[t];
+        old_value_5 = old_weight_5 * fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)];
+
         // Sum and multiply the values in fast registers
         c0 += old_value_5 * old_value_5;
         c1 += old_value_5 * old_value_4;
@@ -165,23 +159,34 @@ __kernel void EstimateAR4Models(__global float* AR1_Estimates,
         c3 += old_value_5 * old_value_2;
         c4 += old_value_5 * old_value_1;
 
+        n0 += old_weight_5;
+        n1 += old_weight_5 * old_weight_4;
+        n2 += old_weight_5 * old_weight_3;
+        n3 += old_weight_5 * old_weight_2;
+        n4 += old_weight_5 * old_weight_1;
+
 		// Save old values
         old_value_1 = old_value_2;
         old_value_2 = old_value_3;
         old_value_3 = old_value_4;
         old_value_4 = old_value_5;
+
+        old_weight_1 = old_weight_2;
+        old_weight_2 = old_weight_3;
+        old_weight_3 = old_weight_4;
+        old_weight_4 = old_weight_5;
     }
 
-    c0 /= ((float)DATA_T - 1.0f - (float)INVALID_TIMEPOINTS);
-    c1 /= ((float)DATA_T - 2.0f - (float)INVALID_TIMEPOINTS);
-    c2 /= ((float)DATA_T - 3.0f - (float)INVALID_TIMEPOINTS);
-    c3 /= ((float)DATA_T - 4.0f - (float)INVALID_TIMEPOINTS);
-    c4 /= ((float)DATA_T - 5.0f - (float)INVALID_TIMEPOINTS);
+    c0 /= (n0 - 1.0f);
+    c1 /= (n1 - 1.0f);
+    c2 /= (n2 - 1.0f);
+    c3 /= (n3 - 1.0f);
+    c4 /= (n4 - 1.0f);
 
     // Calculate alphas
     float4 r, alphas;
 
-    if (c0 != 0.0f)
+    if ( (c0 != 0.0f) && (n4 > 1.0f) )
     {
         r.x = c1/c0;
         r.y = c2/c0;
@@ -244,8 +249,9 @@ __kernel void EstimateAR4ModelsSlice(__global float* AR1_Estimates,
 									 __private int DATA_H, 
 									 __private int DATA_D, 
 									 __private int DATA_T,
-									 __private int INVALID_TIMEPOINTS,
-                                	 __private int slice)
+									 __private int INVALID_TIMEPOINTS,
+                                	 __private int slice,
+									 __constant float* c_Censored_Timepoints)
 {
 	int x = get_global_id(0);
 	int y = get_global_id(1);
@@ -265,34 +271,27 @@ __kernel void EstimateAR4ModelsSlice(__global float* AR1_Estimates,
 	}
 
     int t = 0;
-	float old_value_1, old_value_2, old_value_3, old_value_4, old_value_5;
+	float old_value_1 = 0.0f, old_value_2 = 0.0f, old_value_3 = 0.0f, old_value_4 = 0.0f, old_value_5;
+	float old_weight_1 = 0.0f, old_weight_2 = 0.0f, old_weight_3 = 0.0f, old_weight_4 = 0.0f, old_weight_5;
 	float c0 = 0.0f;
     float c1 = 0.0f;
     float c2 = 0.0f;
     float c3 = 0.0f;
     float c4 = 0.0f;
-
-	old_value_1 = fMRI_Volumes[Calculate3DIndex(x, y, 0 + INVALID_TIMEPOINTS, DATA_W, DATA_H)];
-    c0 += old_value_1 * old_value_1;
-	old_value_2 = fMRI_Volumes[Calculate3DIndex(x, y, 1 + INVALID_TIMEPOINTS, DATA_W, DATA_H)];
-    c0 += old_value_2 * old_value_2;
-    c1 += old_value_2 * old_value_1;
-	old_value_3 = fMRI_Volumes[Calculate3DIndex(x, y, 2 + INVALID_TIMEPOINTS, DATA_W, DATA_H)];
-    c0 += old_value_3 * old_value_3;
-    c1 += old_value_3 * old_value_2;
-    c2 += old_value_3 * old_value_1;
-	old_value_4 = fMRI_Volumes[Calculate3DIndex(x, y, 3 + INVALID_TIMEPOINTS, DATA_W, DATA_H)];
-    c0 += old_value_4 * old_value_4;
-    c1 += old_value_4 * old_value_3;
-    c2 += old_value_4 * old_value_2;
-    c3 += old_value_4 * old_value_1;
-
-    // Estimate c0, c1, c2, c3, c4
-    for (t = 4 + INVALID_TIMEPOINTS; t < DATA_T; t++)
+	float n0 = 0.0f;
+    float n1 = 0.0f;
+    float n2 = 0.0f;
+    float n3 = 0.0f;
+    float n4 = 0.0f;
+
+    // Estimate c0, c1, c2, c3, c4, censored timepoints are set to zero and the sums
+    // are normalized with the number of valid pairs of timepoints for each lag
+    for (t = INVALID_TIMEPOINTS; t < DATA_T; t++)
     {
         // Read data into register
-		old_value_5 = fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)];
-        
+        old_weight_5 = c_Censored_Timepoints[t];
+        old_value_5 = old_weight_5 * fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)];
+
         // Sum and multiply the values in fast registers
         c0 += old_value_5 * old_value_5;
         c1 += old_value_5 * old_value_4;
@@ -300,23 +299,34 @@ __kernel void EstimateAR4ModelsSlice(__global float* AR1_Estimates,
         c3 += old_value_5 * old_value_2;
         c4 += old_value_5 * old_value_1;
 
+        n0 += old_weight_5;
+        n1 += old_weight_5 * old_weight_4;
+        n2 += old_weight_5 * old_weight_3;
+        n3 += old_weight_5 * old_weight_2;
+        n4 += old_weight_5 * old_weight_1;
+
 		// Save old values
         old_value_1 = old_value_2;
         old_value_2 = old_value_3;
         old_value_3 = old_value_4;
         old_value_4 = old_value_5;
+
+        old_weight_1 = old_weight_2;
+        old_weight_2 = old_weight_3;
+        old_weight_3 = old_weight_4;
+        old_weight_4 = old_weight_5;
     }
 
-    c0 /= ((float)DATA_T - 1.0f - (float)INVALID_TIMEPOINTS);
-    c1 /= ((float)DATA_T - 2.0f - (float)INVALID_TIMEPOINTS);
-    c2 /= ((float)DATA_T - 3.0f - (float)INVALID_TIMEPOINTS);
-    c3 /= ((float)DATA_T - 4.0f - (float)INVALID_TIMEPOINTS);
-    c4 /= ((float)DATA_T - 5.0f - (float)INVALID_TIMEPOINTS);
+    c0 /= (n0 - 1.0f);
+    c1 /= (n1 - 1.0f);
+    c2 /= (n2 - 1.0f);
+    c3 /= (n3 - 1.0f);
+    c4 /= (n4 - 1.0f);
 
     // Calculate alphas
     float4 r, alphas;
 
-    if (c0 != 0.0f)
+    if ( (c0 != 0.0f) && (n4 > 1.0f) )
     {
         r.x = c1/c0;
         r.y = c2/c0;
@@ -378,7 +388,8 @@ __kernel void ApplyWhiteningAR4(__global float* Whitened_fMRI_Volumes,
 								__private int DATA_W, 
 								__private int DATA_H, 
 								__private int DATA_D, 
-								__private int DATA_T)
+								__private int DATA_T,
+								__constant float* c_Censored_Timepoints)
 {
 	int x = get_global_id(0);
 	int y = get_global_id(1);
@@ -398,19 +409,19 @@ __kernel void ApplyWhiteningAR4(__global float* Whitened_fMRI_Volumes,
     alphas.z = AR3_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
     alphas.w = AR4_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
 
-    // Calculate the whitened timeseries
-    old_value_1 = fMRI_Volumes[Calculate4DIndex(x, y, z, 0, DATA_W, DATA_H, DATA_D)];	
+    // Calculate the whitened timeseries, censored timepoints are set to zero
+    old_value_1 = c_Censored_Timepoints[0] * fMRI_Volumes[Calculate4DIndex(x, y, z, 0, DATA_W, DATA_H, DATA_D)];	
     Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, 0, DATA_W, DATA_H, DATA_D)] = old_value_1;
-    old_value_2 = fMRI_Volumes[Calculate4DIndex(x, y, z, 1, DATA_W, DATA_H, DATA_D)];
+    old_value_2 = c_Censored_Timepoints[1] * fMRI_Volumes[Calculate4DIndex(x, y, z, 1, DATA_W, DATA_H, DATA_D)];
     Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, 1, DATA_W, DATA_H, DATA_D)] = old_value_2  - alphas.x * old_value_1;
-    old_value_3 = fMRI_Volumes[Calculate4DIndex(x, y, z, 2, DATA_W, DATA_H, DATA_D)];
+    old_value_3 = c_Censored_Timepoints[2] * fMRI_Volumes[Calculate4DIndex(x, y, z, 2, DATA_W, DATA_H, DATA_D)];
     Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, 2, DATA_W, DATA_H, DATA_D)] = old_value_3 - alphas.x * old_value_2 - alphas.y * old_value_1;
-    old_value_4 = fMRI_Volumes[Calculate4DIndex(x, y, z, 3, DATA_W, DATA_H, DATA_D)];
+    old_value_4 = c_Censored_Timepoints[3] * fMRI_Volumes[Calculate4DIndex(x, y, z, 3, DATA_W, DATA_H, DATA_D)];
     Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, 3, DATA_W, DATA_H, DATA_D)] = old_value_4 - alphas.x * old_value_3 - alphas.y * old_value_2 - alphas.z * old_value_1;
     
     for (t = 4; t < DATA_T; t++)
     {
-        old_value_5 = fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)];
+        old_value_5 = c_Censored_Timepoints[t] * fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)];
         Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)] = old_value_5 - alphas.x * old_value_4 - alphas.y * old_value_3 - alphas.z * old_value_2 - alphas.w * old_value_1;
         
 		// Save old values
@@ -432,8 +443,9 @@ __kernel void ApplyWhiteningAR4Slice(__global float* Whitened_fMRI_Volumes,
 									 __private int DATA_W, 
 									 __private int DATA_H, 
 									 __private int DATA_D, 
-									 __private int DATA_T,
-                                	 __private int slice)
+									 __private int DATA_T,
+                                	 __private int slice,
+									 __constant float* c_Censored_Timepoints)
 {
 	int x = get_global_id(0);
 	int y = get_global_id(1);
@@ -453,20 +465,20 @@ __kernel void ApplyWhiteningAR4Slice(__global float* Whitened_fMRI_Volumes,
     alphas.z = AR3_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
     alphas.w = AR4_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
 
-    // Calculate the whitened timeseries
+    // Calculate the whitened timeseries, censored timepoints are set to zero
 
-    old_value_1 = fMRI_Volumes[Calculate3DIndex(x, y,  0, DATA_W, DATA_H)];	
+    old_value_1 = c_Censored_Timepoints[0] * fMRI_Volumes[Calculate3DIndex(x, y, 0, DATA_W, DATA_H)];	
     Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 0, DATA_W, DATA_H)] = old_value_1;
-    old_value_2 = fMRI_Volumes[Calculate3DIndex(x, y, 1, DATA_W, DATA_H)];
+    old_value_2 = c_Censored_Timepoints[1] * fMRI_Volumes[Calculate3DIndex(x, y, 1, DATA_W, DATA_H)];
     Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 1, DATA_W, DATA_H)] = old_value_2  - alphas.x * old_value_1;
-    old_value_3 = fMRI_Volumes[Calculate3DIndex(x, y, 2, DATA_W, DATA_H)];
+    old_value_3 = c_Censored_Timepoints[2] * fMRI_Volumes[Calculate3DIndex(x, y, 2, DATA_W, DATA_H)];
     Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 2, DATA_W, DATA_H)] = old_value_3 - alphas.x * old_value_2 - alphas.y * old_value_1;
-    old_value_4 = fMRI_Volumes[Calculate3DIndex(x, y, 3, DATA_W, DATA_H)];
+    old_value_4 = c_Censored_Timepoints[3] * fMRI_Volumes[Calculate3DIndex(x, y, 3, DATA_W, DATA_H)];
     Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 3, DATA_W, DATA_H)] = old_value_4 - alphas.x * old_value_3 - alphas.y * old_value_2 - alphas.z * old_value_1;
 
     for (t = 4; t < DATA_T; t++)
     {
-        old_value_5 = fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)];
+        old_value_5 = c_Censored_Timepoints[t] * fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)];
         Whitened_fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)] = old_value_5 - alphas.x * old_value_4 - alphas.y * old_value_3 - alphas.z * old_value_2 - alphas.w * old_value_1;
 
 		// Save old values
@@ -477,18 +489,23 @@ __kernel void ApplyWhiteningAR4Slice(__global float* Whitened_fMRI_Volumes,
     }
 }
 
-__kernel void GeneratePermutedVolumesFirstLevel(__global float* Permuted_fMRI_Volumes, 
-                                                __global const float* Whitened_fMRI_Volumes, 
-												__global const float* AR1_Estimates, 
-												__global const float* AR2_Estimates, 
-												__global const float* AR3_Estimates, 
-												__global const float* AR4_Estimates, 
-												__global const float* Mask, 
-												__constant unsigned short int *c_Permutation_Vector, 
-												__private int DATA_W, 
-												__private int DATA_H, 
-												__private int DATA_D, 
-												__private int DATA_T)
+// Same as ApplyWhiteningAR4Slice, but the original data are stored as the mean of each voxel (float) and the deviations from
+// the mean as half floats, multiplied with a common scale. The data are converted back to float, all arithmetic is done in float
+__kernel void ApplyWhiteningAR4SliceHalf(__global float* Whitened_fMRI_Volumes, 
+                                    	 __global const half* fMRI_Volumes, 
+										 __global const float* Means, 
+										 __global const float* AR1_Estimates, 
+										 __global const float* AR2_Estimates, 
+										 __global const float* AR3_Estimates, 
+										 __global const float* AR4_Estimates, 
+										 __global const float* Mask, 
+										 __private int DATA_W, 
+										 __private int DATA_H, 
+										 __private int DATA_D, 
+										 __private int DATA_T,
+                                    	 __private int slice,
+										 __constant float* c_Censored_Timepoints,
+										 __private float inverse_scale)
 {
 	int x = get_global_id(0);
 	int y = get_global_id(1);
@@ -497,42 +514,74 @@ __kernel void GeneratePermutedVolumesFirstLevel(__global float* Permuted_fMRI_Vo
     if ( x >= DATA_W || y >= DATA_H || z >= DATA_D )
         return;
 
-    if ( Mask[Calculate3DIndex(x, y, z, DATA_W, DATA_H)] != 1.0f )
+    if ( Mask[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)] != 1.0f )
 		return;
 
     int t = 0;
 	float old_value_1, old_value_2, old_value_3, old_value_4, old_value_5;
-	float4 alphas;
-	alphas.x = AR1_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
-    alphas.y = AR2_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
-    alphas.z = AR3_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
-    alphas.w = AR4_Estimates[Calculate3DIndex(x, y, z, DATA_W, DATA_H)];
+    float4 alphas;
+	alphas.x = AR1_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
+    alphas.y = AR2_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
+    alphas.z = AR3_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
+    alphas.w = AR4_Estimates[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
+	float mean = Means[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)];
 
-    old_value_1 = Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, c_Permutation_Vector[0], DATA_W, DATA_H, DATA_D)];
-	old_value_2 = alphas.x * old_value_1  + Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, c_Permutation_Vector[1], DATA_W, DATA_H, DATA_D)];
-	old_value_3 = alphas.x * old_value_2  + alphas.y * old_value_1 + Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, c_Permutation_Vector[2], DATA_W, DATA_H, DATA_D)];
-	old_value_4 = alphas.x * old_value_3  + alphas.y * old_value_2 + alphas.z * old_value_1 + Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, c_Permutation_Vector[3], DATA_W, DATA_H, DATA_D)];
+    // Calculate the whitened timeseries, censored timepoints are set to zero
 
-    Permuted_fMRI_Volumes[Calculate4DIndex(x, y, z, 0, DATA_W, DATA_H, DATA_D)] =  old_value_1;
-    Permuted_fMRI_Volumes[Calculate4DIndex(x, y, z, 1, DATA_W, DATA_H, DATA_D)] =  old_value_2;
-    Permuted_fMRI_Volumes[Calculate4DIndex(x, y, z, 2, DATA_W, DATA_H, DATA_D)] =  old_value_3;
-    Permuted_fMRI_Volumes[Calculate4DIndex(x, y, z, 3, DATA_W, DATA_H, DATA_D)] =  old_value_4;
+    old_value_1 = c_Censored_Timepoints[0] * (mean + inverse_scale * vload_half(Calculate3DIndex(x, y, 0, DATA_W, DATA_H), fMRI_Volumes));
+    Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 0, DATA_W, DATA_H)] = old_value_1;
+    old_value_2 = c_Censored_Timepoints[1] * (mean + inverse_scale * vload_half(Calculate3DIndex(x, y, 1, DATA_W, DATA_H), fMRI_Volumes));
+    Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 1, DATA_W, DATA_H)] = old_value_2  - alphas.x * old_value_1;
+    old_value_3 = c_Censored_Timepoints[2] * (mean + inverse_scale * vload_half(Calculate3DIndex(x, y, 2, DATA_W, DATA_H), fMRI_Volumes));
+    Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 2, DATA_W, DATA_H)] = old_value_3 - alphas.x * old_value_2 - alphas.y * old_value_1;
+    old_value_4 = c_Censored_Timepoints[3] * (mean + inverse_scale * vload_half(Calculate3DIndex(x, y, 3, DATA_W, DATA_H), fMRI_Volumes));
+    Whitened_fMRI_Volumes[Calculate3DIndex(x, y, 3, DATA_W, DATA_H)] = old_value_4 - alphas.x * old_value_3 - alphas.y * old_value_2 - alphas.z * old_value_1;
 
-    // Read the data in a permuted order and apply an inverse whitening transform
     for (t = 4; t < DATA_T; t++)
     {
-        // Calculate the unwhitened, permuted, timeseries
-        old_value_5 = alphas.x * old_value_4 + alphas.y * old_value_3 + alphas.z * old_value_2 + alphas.w * old_value_1 + Whitened_fMRI_Volumes[Calculate4DIndex(x, y, z, c_Permutation_Vector[t], DATA_W, DATA_H, DATA_D)];
-			
-        Permuted_fMRI_Volumes[Calculate4DIndex(x, y, z, t, DATA_W, DATA_H, DATA_D)] = old_value_5;
+        old_value_5 = c_Censored_Timepoints[t] * (mean + inverse_scale * vload_half(Calculate3DIndex(x, y, t, DATA_W, DATA_H), fMRI_Volumes));
+        Whitened_fMRI_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)] = old_value_5 - alphas.x * old_value_4 - alphas.y * old_value_3 - alphas.z * old_value_2 - alphas.w * old_value_1;
 
-        // Save old values
-		old_value_1 = old_value_2;
+		// Save old values
+        old_value_1 = old_value_2;
         old_value_2 = old_value_3;
         old_value_3 = old_value_4;
         old_value_4 = old_value_5;
     }
 }
 
+// Stores all time points of one slice (x, y, t) as half floats in the 4D volumes (x, y, z, t)
+// The values are multiplied with a common scale, to keep them well inside the range of half floats
+__kernel void StoreSliceHalf(__global half* Volumes,
+                             __global const float* Slice_Volumes,
+                             __global const float* Mask,
+                             __private float scale,
+                             __private int DATA_W,
+                             __private int DATA_H,
+                             __private int DATA_D,
+                             __private int DATA_T,
+                             __private int slice)
+{
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+    if ( x >= DATA_W || y >= DATA_H )
+        return;
+
+    if ( Mask[Calculate3DIndex(x, y, slice, DATA_W, DATA_H)] != 1.0f )
+	{
+		for (int t = 0; t < DATA_T; t++)
+		{
+			vstore_half(0.0f, Calculate4DIndex(x, y, slice, t, DATA_W, DATA_H, DATA_D), Volumes);
+		}
+		return;
+	}
+
+	for (int t = 0; t < DATA_T; t++)
+	{
+		vstore_half(scale * Slice_Volumes[Calculate3DIndex(x, y, t, DATA_W, DATA_H)], Calculate4DIndex(x, y, slice, t, DATA_W, DATA_H, DATA_D), Volumes);
+	}
+}
+
 
 